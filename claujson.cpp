@@ -4,9 +4,17 @@
 #include <future>
 
 #include <set>
+#include <list>
 #include <execution>
 #include <array>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "fmt/format.h"
 
 #if __cpp_lib_string_view
@@ -26,7 +34,8 @@
 	namespace claujson {
 
 
-		int64_t Arena::counter = 0;
+		std::atomic<int64_t> Arena::counter{ 0 };
+		std::atomic<uint64_t> Arena::shard_epoch_counter{ 1 };
 
 		// todo? make Document class? like simdjson?
 		_Value _Value::empty_value{ nullptr, false }; // valid is false..
@@ -367,38 +376,38 @@
 		}
 
 
-		void StructuredPtr::MergeWith(StructuredPtr j, int start_offset) {
+		void StructuredPtr::MergeWith(StructuredPtr j, int start_offset, bool update_parent) {
 			if (type == 1) {
 				if (j.is_array()) {
-					return arr->MergeWith(j.arr, start_offset);
+					return arr->MergeWith(j.arr, start_offset, update_parent);
 				}
 				if (j.is_object()) {
-					return arr->MergeWith(j.obj, start_offset);
+					return arr->MergeWith(j.obj, start_offset, update_parent);
 				}
 				if (j.is_partial_json()) {
-					return arr->MergeWith(j.pj, start_offset);
+					return arr->MergeWith(j.pj, start_offset, update_parent);
 				}
 			}
 			if (type == 2) {
 				if (j.is_array()) {
-					return obj->MergeWith(j.arr, start_offset);
+					return obj->MergeWith(j.arr, start_offset, update_parent);
 				}
 				if (j.is_object()) {
-					return obj->MergeWith(j.obj, start_offset);
+					return obj->MergeWith(j.obj, start_offset, update_parent);
 				}
 				if (j.is_partial_json()) {
-					return obj->MergeWith(j.pj, start_offset);
+					return obj->MergeWith(j.pj, start_offset, update_parent);
 				}
 			}
 			if (type == 3) {
 				if (j.is_array()) {
-					return pj->MergeWith(j.arr, start_offset);
+					return pj->MergeWith(j.arr, start_offset, update_parent);
 				}
 				if (j.is_object()) {
-					return pj->MergeWith(j.obj, start_offset);
+					return pj->MergeWith(j.obj, start_offset, update_parent);
 				}
 				if (j.is_partial_json()) {
-					return pj->MergeWith(j.pj, start_offset);
+					return pj->MergeWith(j.pj, start_offset, update_parent);
 				}
 			}
 		}
@@ -412,16 +421,25 @@
 			}
 			return;
 		}
+		void StructuredPtr::shrink_data_list() {
+			if (type == 1) {
+				return arr->shrink_data_list();
+			}
+			if (type == 2) {
+				return obj->shrink_data_list();
+			}
+			return;
+		}
 
 		// need rename param....!
 
 		void StructuredPtr::add_item_type(int64_t key_buf_idx, int64_t key_next_buf_idx, int64_t val_buf_idx, int64_t val_next_buf_idx,
-			char* buf, uint64_t key_token_idx, uint64_t val_token_idx, Arena* pool) {
+			char* buf, uint64_t key_token_idx, uint64_t val_token_idx, Arena* pool, const _Value* shape_key) {
 			if (type == 1) {
 				return arr->add_item_type(key_buf_idx, key_next_buf_idx, val_buf_idx, val_next_buf_idx, buf, key_token_idx, val_token_idx);
 			}
 			if (type == 2) {
-				return obj->add_item_type(key_buf_idx, key_next_buf_idx, val_buf_idx, val_next_buf_idx, buf, key_token_idx, val_token_idx, pool);
+				return obj->add_item_type(key_buf_idx, key_next_buf_idx, val_buf_idx, val_next_buf_idx, buf, key_token_idx, val_token_idx, pool, shape_key);
 			}
 			if (type == 3) {
 				return pj->add_item_type(key_buf_idx, key_next_buf_idx, val_buf_idx, val_next_buf_idx, buf, key_token_idx, val_token_idx);
@@ -446,12 +464,12 @@
 		}
 
 		void StructuredPtr::add_user_type(int64_t key_buf_idx, int64_t key_next_buf_idx, char* buf,
-			_ValueType type, uint64_t key_token_idx, Arena* pool) {
+			_ValueType type, uint64_t key_token_idx, Arena* pool, const _Value* shape_key) {
 			if (this->type == 1) {
 				return arr->add_user_type(key_buf_idx, key_next_buf_idx, buf, type, key_token_idx, pool);
 			}
 			if (this->type == 2) {
-				return obj->add_user_type(key_buf_idx, key_next_buf_idx, buf, type, key_token_idx, pool);
+				return obj->add_user_type(key_buf_idx, key_next_buf_idx, buf, type, key_token_idx, pool, shape_key);
 			}
 			if (this->type == 3) {
 				return pj->add_user_type(key_buf_idx, key_next_buf_idx, buf, type, key_token_idx, pool);
@@ -521,7 +539,7 @@
 				return stream;
 			}
 
-			switch (data._type) {
+			switch (data.type()) {
 			case claujson::_ValueType::INT:
 				stream << data._int_val;
 				break;
@@ -598,6 +616,27 @@ namespace claujson {
 		return route.substr(found_idx + 1, new_idx - found_idx - 1);
 	}
 #endif
+	// padded copy of number text for parse_number, on stack. (long text -> heap)
+	class NumberScratch {
+	private:
+		uint8_t buf[64 + _simdjson::_SIMDJSON_PADDING];
+		std::unique_ptr<uint8_t[]> heap;
+	public:
+		const uint8_t* copy(const char* text, uint64_t len) {
+			uint8_t* result = buf;
+			if (len > 64) {
+				heap = std::unique_ptr<uint8_t[]>(new (std::nothrow) uint8_t[len + _simdjson::_SIMDJSON_PADDING]);
+				result = heap.get();
+				if (!result) {
+					return nullptr;
+				}
+			}
+			std::memcpy(result, text, len);
+			std::memset(result + len, ' ', _simdjson::_SIMDJSON_PADDING);
+			return result;
+		}
+	};
+
 	claujson_inline bool to_uint_for_json_pointer(StringView x, uint64_t* val, _simdjson::internal::dom_parser_implementation* simdjson_imple) {
 		const char* buf = x.data();
 		uint64_t idx = 0;
@@ -608,19 +647,12 @@ namespace claujson {
 		case '1': case '2': case '3': case '4':
 		case '5': case '6': case '7': case '8': case '9':
 		{
-			std::unique_ptr<uint8_t[]> copy;
+			NumberScratch scratch;
 
 			uint64_t temp[2] = { 0 };
 
-			const uint8_t* value = reinterpret_cast<const uint8_t*>(buf + idx);
-
-			{ // chk code...
-				copy = std::unique_ptr<uint8_t[]>(new (std::nothrow) uint8_t[idx2 - idx + _simdjson::_SIMDJSON_PADDING]); // x.size() + padding
-				if (copy.get() == nullptr) { return false; } // cf) new Json?
-				std::memcpy(copy.get(), &buf[idx], idx2 - idx);
-				std::memset(copy.get() + idx2 - idx, ' ', _simdjson::_SIMDJSON_PADDING);
-				value = copy.get();
-			}
+			const uint8_t* value = scratch.copy(reinterpret_cast<const char*>(buf + idx), idx2 - idx); // x.size() + padding
+			if (!value) { return false; }
 			auto x = simdjson_imple->parse_number(value, temp);
 
 			if (x != _simdjson::SUCCESS) {
@@ -667,19 +699,12 @@ namespace claujson {
 		case '1': case '2': case '3': case '4':
 		case '5': case '6': case '7': case '8': case '9':
 		{
-			std::unique_ptr<uint8_t[]> copy;
+			NumberScratch scratch;
 
 			uint64_t temp[2] = { 0 };
 
-			const uint8_t* value = reinterpret_cast<const uint8_t*>(buf + idx);
-
-			{ // chk code...
-				copy = std::unique_ptr<uint8_t[]>(new (std::nothrow) uint8_t[idx2 - idx + _simdjson::_SIMDJSON_PADDING]); // x.size() + padding
-				if (copy.get() == nullptr) { return false; } // cf) new Json?
-				std::memcpy(copy.get(), &buf[idx], idx2 - idx);
-				std::memset(copy.get() + idx2 - idx, ' ', _simdjson::_SIMDJSON_PADDING);
-				value = copy.get();
-			}
+			const uint8_t* value = scratch.copy(reinterpret_cast<const char*>(buf + idx), idx2 - idx); // x.size() + padding
+			if (!value) { return false; }
 
 			if (auto x = simdjson_imple->parse_number(value, temp)
 				; x != _simdjson::SUCCESS) {
@@ -728,8 +753,23 @@ namespace claujson {
 		}
 	}
 
+	_Value Document::MakeKey(StringView key) {
+		_Value result;
+		result.set_key_in_parse(pool, key.data(), key.size());
+		return result;
+	}
+
 	claujson_inline 
-	bool ConvertString(Arena* pool, claujson::_Value& data, const char* text, uint64_t len) {
+	bool ConvertString(Arena* pool, claujson::_Value& data, const char* text, uint64_t len, bool key, const _Value* shape_key) {
+		// text is in input kept in pool.
+		if (!key && pool && pool->IsZeroCopy() && data.set_str_zero_copy(pool, const_cast<char*>(text), len)) {
+			return true;
+		}
+
+		if (pool) { // no temporary buffer.
+			return data.set_str_unescape(pool, text, len, key, shape_key);
+		}
+
 		uint8_t sbuf[1024 + 1 + _simdjson::_SIMDJSON_PADDING];
 		std::unique_ptr<uint8_t[]> ubuf;
 		uint8_t* string_buf = nullptr;
@@ -748,27 +788,28 @@ namespace claujson {
 		else {
 			*x = '\0';
 			auto string_length = uint32_t(x - string_buf);
-			data.set_str_in_parse(pool, reinterpret_cast<char*>(string_buf), string_length);
+			if (key) { // (shape share is only with pool)
+				data.set_key_in_parse(pool, reinterpret_cast<char*>(string_buf), string_length);
+			}
+			else {
+				data.set_str_in_parse(pool, reinterpret_cast<char*>(string_buf), string_length);
+			}
 		}
 		return true;
 	}
 
 	claujson_inline bool ConvertNumber(claujson::_Value& data, const char* text, uint64_t len, bool isFirst) {
 
-		std::unique_ptr<uint8_t[]> copy;
+		NumberScratch scratch;
 
 		uint64_t temp[2] = { 0 };
 
 		const uint8_t* value = reinterpret_cast<const uint8_t*>(text);
 
 
-		// todo : number -> fixed size? -> len <- limit... -> no new!
 		if (isFirst) { // if this case may be root number -> chk.. visit_root_number. in tape_builder in simdjson.cpp
-			copy = std::unique_ptr<uint8_t[]>(new (std::nothrow) uint8_t[len + _simdjson::_SIMDJSON_PADDING]);
-			if (copy.get() == nullptr) { return false; } // ERROR("Error in Convert for new"); } // cf) new Json?
-			std::memcpy(copy.get(), text, len);
-			std::memset(copy.get() + len, ' ', _simdjson::_SIMDJSON_PADDING);
-			value = copy.get();
+			value = scratch.copy(text, len);
+			if (!value) { return false; } // ERROR("Error in Convert for new"); } // cf) new Json?
 		}
 
 		auto x = _simdjson::parse_number(value, temp);
@@ -806,16 +847,30 @@ namespace claujson {
 	}
 
 	claujson::_Value& Convert(Arena* pool, claujson::_Value& data, uint64_t buf_idx, uint64_t next_buf_idx, bool key,
-		char* buf, uint64_t token_idx, bool& err) {
+		char* buf, uint64_t token_idx, bool& err, const _Value* shape_key) {
 		
 		data.clear(true);
 
 		int ch = buf[buf_idx];
 		//try {
+
+		// lazy -> keep position only, (token_idx == 0 : root number -> not lazy)
+		if (!key && token_idx != 0 && pool && pool->IsLazy()) {
+			if (ch == '"') {
+				if (!data.set_lazy_str(pool, &buf[buf_idx], next_buf_idx - buf_idx)) {
+					goto ERR;
+				}
+				return data;
+			}
+			else if (ch == '-' || (ch >= '0' && ch <= '9')) {
+				data.set_lazy_number(&buf[buf_idx]);
+				return data;
+			}
+		}
 		
 		switch (ch) {
 		case '"':
-			if (ConvertString(pool, data, &buf[buf_idx], next_buf_idx - buf_idx)) {}
+			if (ConvertString(pool, data, &buf[buf_idx], next_buf_idx - buf_idx, key, shape_key)) {}
 			else {
 				goto ERR;
 			}
@@ -875,6 +930,57 @@ namespace claujson {
 		return data;
 	}
 
+	// mutex of a lazy value, (striped) first accesses of other values are not blocked.
+	static std::mutex& LazyMutex(const void* p) {
+		static std::mutex mtx[64];
+		return mtx[(reinterpret_cast<uintptr_t>(p) >> 6) % 64];
+	}
+
+	_ValueType _Value::resolve() const {
+		_Value& self = const_cast<_Value&>(*this);
+		_ValueType type = load_type();
+
+		if (type == _ValueType::LAZY_STRING) {
+			std::lock_guard<std::mutex> lock(LazyMutex(this));
+
+			type = load_type();
+			if (type != _ValueType::LAZY_STRING) {
+				return type;
+			}
+
+			// buffer from shard of calling thread, like other concurrent allocations. (not Arena of Document)
+			Arena* pool = _str_val->pool->GetShard();
+			if (pool && resolve_str(pool)) {
+				type = _ValueType::STRING;
+			}
+			else {
+				log << warn << "Error in lazy string\n";
+				type = _ValueType::ERROR;
+			}
+			self.store_type(type);
+		}
+		else if (type == _ValueType::LAZY_NUMBER) {
+			std::lock_guard<std::mutex> lock(LazyMutex(this));
+
+			type = load_type();
+			if (type != _ValueType::LAZY_NUMBER) {
+				return type;
+			}
+
+			_Value temp;
+			if (ConvertNumber(temp, reinterpret_cast<const char*>(_int_val), 0, false)) { // input is padded.
+				self._int_val = temp._int_val;
+				type = temp._type;
+			}
+			else {
+				type = _ValueType::ERROR;
+			}
+			self.store_type(type);
+		}
+
+		return type;
+	}
+
 	//bool Structured::is_valid() const {
 	//	return valid;
 	//}
@@ -1043,9 +1149,117 @@ namespace claujson {
 		}
 	};
 
+	bool is_valid2(const char* buf, _simdjson::internal::dom_parser_implementation* simdjson_imple, uint64_t start, uint64_t last,
+		int* _start_state, int* _last_state,
+		Vector<int8_t>* _is_array, Vector<int8_t>* _is_virtual_array,
+		uint64_t* count = nullptr, bool whole = false, // whole : [start, last] is one json value. (ex) a line of ndjson)
+		Vector<uint64_t>* _open = nullptr, Vector<uint64_t>* _virtual_count = nullptr, // for is_valid2_count
+		uint64_t count_base = 0); // count[idx - count_base], (count of one part)
+
+	int is_valid2_merge(const my_vector<int>& start_state, const my_vector<int>& last_state,
+		my_vector<Vector<int8_t>>& is_array, my_vector<Vector<int8_t>>& is_virtual_array, uint64_t n);
+
+	void is_valid2_count(my_vector<Vector<uint64_t>>& open, my_vector<Vector<uint64_t>>& virtual_count, uint64_t* count, uint64_t n);
+
+	// for chunked stage1, next of ',' after idx. (or buf_len)
+	static uint64_t FindChunkEnd(const char* buf, uint64_t buf_len, uint64_t idx) {
+		if (idx >= buf_len) {
+			return buf_len;
+		}
+		const char* x = (const char*)memchr(buf + idx, ',', buf_len - idx);
+		if (!x) {
+			return buf_len;
+		}
+		return x - buf + 1;
+	}
+
+	// '"' at or after idx, not escaped. (or buf_len) backslashes are counted from `from`, like stage1. (escaped out of string too)
+	static uint64_t NextQuote(const char* buf, uint64_t buf_len, uint64_t from, uint64_t idx) {
+		while (idx < buf_len) {
+			const char* x = (const char*)memchr(buf + idx, '"', buf_len - idx);
+			if (!x) {
+				return buf_len;
+			}
+			uint64_t quote = x - buf;
+			uint64_t backslash = 0;
+			while (quote - backslash > from && buf[quote - backslash - 1] == '\\') {
+				++backslash;
+			}
+			if (backslash % 2 == 0) {
+				return quote;
+			}
+			idx = quote + 1;
+		}
+		return buf_len;
+	}
+
+	// for chunked stage1, next of ',' after idx, out of string. buf[offset] is not in string.
+	// one forward scan from offset, (in string or not) -> buf_len if no ',', buf_len + 1 if a string is not closed.
+	static uint64_t FindChunkEnd(const char* buf, uint64_t buf_len, uint64_t offset, uint64_t idx) {
+		uint64_t pos = offset;
+		while (true) {
+			const uint64_t quote = NextQuote(buf, buf_len, offset, pos); // start of string
+			const uint64_t from = std::max(pos, idx);
+			if (from < quote) {
+				const char* x = (const char*)memchr(buf + from, ',', quote - from);
+				if (x) {
+					return x - buf + 1;
+				}
+			}
+			if (quote >= buf_len) {
+				return buf_len;
+			}
+			const uint64_t end_quote = NextQuote(buf, buf_len, offset, quote + 1);
+			if (end_quote >= buf_len) {
+				return buf_len + 1;
+			}
+			pos = end_quote + 1;
+		}
+	}
+
+	// stage1 for buf[offset, *end), buf[*end - 1] == ',' or *end == buf_len, buf[offset] is not in string.
+	// if buf[*end - 1] is in string, *end is moved to the next ',' after the string, (only once)
+	// and UNCLOSED_STRING is returned if the string is not closed. (ex) stray '"', not scanned again and again)
+	static _simdjson::error_code stage1_chunk(_simdjson::internal::dom_parser_implementation* imple,
+		const char* buf, uint64_t buf_len, uint64_t offset, uint64_t* end) {
+		bool moved = false;
+		while (true) {
+			if (imple->capacity() < *end - offset) {
+				auto e = imple->allocate(*end - offset, _simdjson::DEFAULT_MAX_DEPTH);
+				if (e != _simdjson::error_code::SUCCESS) {
+					return e;
+				}
+			}
+			auto e = imple->stage1(reinterpret_cast<const uint8_t*>(buf) + offset, *end - offset, _simdjson::stage1_mode::regular);
+			if (e == _simdjson::error_code::UNCLOSED_STRING && *end < buf_len && !moved) {
+				// the ',' is in string.
+				const uint64_t x = FindChunkEnd(buf, buf_len, offset, *end);
+				if (x > buf_len) {
+					return _simdjson::error_code::UNCLOSED_STRING;
+				}
+				*end = x;
+				moved = true;
+				continue;
+			}
+			return e;
+		}
+	}
+
 	class LoadData2 {
 	private:
 		ThreadPool* pool;
+
+		// Merge updates only parent of last moved item, (to find next parent)
+		// parent of other moved items is updated after all Merges, in parallel. (UpdateParents)
+		struct ParentJob {
+			StructuredPtr target;
+			uint64_t from;
+			uint64_t to;
+		};
+		std::vector<ParentJob> parent_jobs;
+	public:
+		double imbalance = 1.0; // slowest / average time of __LoadData tasks, in last _LoadData.
+		my_vector<uint64_t> item_num; // items at depth 0 of each part, from is_valid2. (reserve of PartialJson, can be empty)
 	public:
 		LoadData2(ThreadPool* pool) : pool(pool) {
 			//
@@ -1288,6 +1502,7 @@ namespace claujson {
 					out->arr_vec = parent.arr->arr_vec.Divide(idx + 1);
 				}
 				else {
+					parent.obj->drop_index();
 					out->obj_data = parent.obj->obj_data.Divide(idx + 1);
 				}
 				/*
@@ -1524,7 +1739,11 @@ namespace claujson {
 					++start_offset;
 				}
 
-				_next.MergeWith(_ut, start_offset);
+				{
+					const uint64_t from = _next.get_data_size();
+					_next.MergeWith(_ut, start_offset, false);
+					parent_jobs.push_back({ _next, from, _next.get_data_size() });
+				}
 
 				if (_ut.get_data_size() > 0 && _ut.get_value_list(0).is_structured() && _ut.get_value_list(0).is_virtual()) {
 					//clean(_ut.get_value_list(0));
@@ -1624,21 +1843,49 @@ namespace claujson {
 
 		struct TokenTemp { // need to rename.
 			// 
-			int64_t buf_idx;  // buf_idx?
-			int64_t next_buf_idx; // next_buf_idx?
+			int64_t buf_idx = 0;  // buf_idx?
+			int64_t next_buf_idx = 0; // next_buf_idx?
 			//Json
-			uint64_t token_idx; // token_idx?
+			uint64_t token_idx = 0; // token_idx?
 			//
 			bool is_key = false;
 		};
 
+		 // key at next idx of shape, shape is object of same layout to now. (nullptr -> none)
+		 static const _Value* ShapeKey(const Object* shape, const StructuredPtr& now) {
+			 if (!shape) {
+				 return nullptr;
+			 }
+			 const uint64_t idx = now.get_data_size();
+			 return idx < shape->get_data_size() ? &shape->get_key_list(idx) : nullptr;
+		 }
+
+		 // shape for last item of now (new object), shape of now is parent_shape.
+		 // in array -> item before, in object -> item at same idx of parent_shape.
+		 static const Object* ShapeOf(const Object* parent_shape, const StructuredPtr& now) {
+			 const uint64_t idx = now.get_data_size() - 1;
+			 const _Value* x = nullptr;
+
+			 if (now.is_array() || now.is_partial_json()) {
+				 if (idx > 0) {
+					 x = &now.get_value_list(idx - 1);
+				 }
+			 }
+			 else if (parent_shape && idx < parent_shape->get_data_size()) {
+				 x = &parent_shape->get_value_list(idx);
+			 }
+			 return x && x->is_object() ? x->as_object() : nullptr;
+		 }
+
+		 // count_vec == nullptr -> no reserve, and check grammar here (no is_valid2 pass), tokens must start with ',' if token_arr_start > 0.
+		 // (checks between parts are done in Merge)
 		 static bool __LoadData(char* buf, uint64_t buf_len,
 			_simdjson::internal::dom_parser_implementation* imple,
 			int64_t token_arr_start, uint64_t token_arr_len, StructuredPtr _global,
 			int start_state, int last_state, // this line : now not used..
 			class StructuredPtr* next, uint64_t* count_vec, 
 
-			 int* err, uint64_t no, Arena* pool)
+			 int* err, uint64_t no, Arena* pool, uint64_t count_base = 0)
 		 {
 			try {
 				if (token_arr_len <= 0) {
@@ -1647,7 +1894,7 @@ namespace claujson {
 				
 				// token_arr_len >= 1
 
-				uint64_t left_no = token_arr_start;
+				uint64_t left_no = token_arr_start - count_base;
 
 				class StructuredPtr global = _global;
 
@@ -1657,16 +1904,64 @@ namespace claujson {
 
 				TokenTemp key;
 
+				const bool validate = count_vec == nullptr;
+				const bool is_first = token_arr_start == 0; // first part has root.
+				bool after_value = !is_first; // before ','
+				bool after_open = false;
+				int top_kind = 0; // at braceNum == 0 : 1 - key and value, 2 - value only.
+
+				const bool share = pool && pool->IsShapeShare();
+				std::vector<const Object*> shapes; // shapes[braceNum] : object of same layout to nowUT, built before. (nullptr -> none)
+				if (share) {
+					shapes.push_back(nullptr);
+				}
+
 				for (uint64_t i = 0; i < token_arr_len; ++i) {
 					const char type = (buf[imple->structural_indexes[token_arr_start + i]]);
 
 					switch (type) {
 					case ',':
+						if (validate) {
+							if (!after_value || key.is_key || (is_first && braceNum == 0)) {
+								ERROR("wrong comma");
+							}
+							after_value = false;
+							after_open = false;
+						}
 						continue;
 					default:
 					{
 						bool is_key = token_arr_start + i + 1 < imple->n_structural_indexes && buf[imple->structural_indexes[token_arr_start + i + 1]] == ':';
 
+						if (validate) {
+							if (type == ':') {
+								ERROR("wrong colon");
+							}
+							if (after_value || key.is_key && is_key) {
+								ERROR("no comma between values");
+							}
+							if (is_key) {
+								if (type != '"' || (braceNum > 0 && nowUT.is_array()) || (is_first && braceNum == 0)) {
+									ERROR("wrong key");
+								}
+								if (i + 1 >= token_arr_len) { // value is in next part.
+									ERROR("wrong key");
+								}
+							}
+							else if (!key.is_key && braceNum > 0 && nowUT.is_object()) {
+								ERROR("no key in object");
+							}
+							if (braceNum == 0 && !is_first && !key.is_key) {
+								const int kind = is_key ? 1 : 2;
+								if (top_kind != 0 && top_kind != kind) {
+									ERROR("key and value mixed");
+								}
+								top_kind = kind;
+							}
+							after_value = !is_key;
+							after_open = false;
+						}
+
 						{
 							TokenTemp data;
 
@@ -1693,7 +1988,7 @@ namespace claujson {
 								if (key.is_key) {
 									nowUT.add_item_type(key.buf_idx, key.next_buf_idx, 
 										data.buf_idx, data.next_buf_idx, buf,
-										key.token_idx, data.token_idx, pool);
+										key.token_idx, data.token_idx, pool, share ? ShapeKey(shapes[braceNum], nowUT) : nullptr);
 									key.is_key = false;
 								}
 								else {
@@ -1708,10 +2003,23 @@ namespace claujson {
 					case '[':
 						// Left 1
 					{ // object start, array start
+						if (validate) {
+							if (after_value || (!key.is_key && braceNum > 0 && nowUT.is_object())) {
+								ERROR("wrong object or array start");
+							}
+							if (braceNum == 0 && !is_first) {
+								const int kind = key.is_key ? 1 : 2;
+								if (top_kind != 0 && top_kind != kind) {
+									ERROR("key and value mixed");
+								}
+								top_kind = kind;
+							}
+							after_open = true;
+						}
 
 						if (key.is_key) {
 							nowUT.add_user_type(key.buf_idx, key.next_buf_idx, buf,
-								type == '{' ? _ValueType::OBJECT : _ValueType::ARRAY, key.token_idx, pool
+								type == '{' ? _ValueType::OBJECT : _ValueType::ARRAY, key.token_idx, pool, share ? ShapeKey(shapes[braceNum], nowUT) : nullptr
 							); // object vs array
 							key.is_key = false;
 						}
@@ -1721,18 +2029,43 @@ namespace claujson {
 						}
 						
 						class StructuredPtr pTemp = nowUT.get_value_list(nowUT.get_data_size() - 1);
+
+						if (share) {
+							const Object* shape = type == '{' ? ShapeOf(shapes[braceNum], nowUT) : nullptr;
+							if (shapes.size() > braceNum + 1) {
+								shapes[braceNum + 1] = shape;
+							}
+							else {
+								shapes.push_back(shape);
+							}
+						}
 						
 						braceNum++;
 
 						/// initial new nestedUT.
 						nowUT = pTemp;
-						nowUT.reserve_data_list(count_vec[left_no++]);
+						if (count_vec) {
+							nowUT.reserve_data_list(count_vec[left_no++]);
+						}
 					}
 					break;
 					// Right 2
 					case '}':
 					case ']':
 					{
+						if (validate) {
+							if (key.is_key || (!after_value && !after_open) || (is_first && braceNum == 0)
+								|| (braceNum > 0 && (type == '}' ? !nowUT.is_object() : !nowUT.is_array()))
+								|| (braceNum == 0 && top_kind == (type == '}' ? 2 : 1))) {
+								ERROR("wrong object or array end");
+							}
+							if (braceNum == 0) {
+								top_kind = 0;
+							}
+							after_value = true;
+							after_open = false;
+						}
+
 						if (braceNum == 0) {
 
 							_Value _ut; // is v_array or v_object.
@@ -1788,6 +2121,12 @@ namespace claujson {
 						else {
 							braceNum--;
 
+							if (validate) { // no count before, so exact size at end.
+								nowUT.shrink_data_list();
+							}
+							if (nowUT.is_object() && nowUT.get_data_size() >= Object::index_threshold) { // for const find, (it does not allocate)
+								nowUT.obj->build_index();
+							}
 							nowUT = nowUT.get_parent();
 							
 						}
@@ -1797,6 +2136,10 @@ namespace claujson {
 					}
 				}
 
+				if (validate && !after_value) {
+					ERROR("part ends without value");
+				}
+
 				if (next) {
 					*next = nowUT;
 				}
@@ -1817,6 +2160,18 @@ namespace claujson {
 			}
 		}
 
+		 // __LoadData, *time <- elapsed time (us)
+		 static bool __TimedLoadData(char* buf, uint64_t buf_len,
+			 _simdjson::internal::dom_parser_implementation* imple,
+			 int64_t token_arr_start, uint64_t token_arr_len, StructuredPtr _global,
+			 class StructuredPtr* next, uint64_t* count_vec, int* err, uint64_t no, Arena* pool, uint64_t* time)
+		 {
+			 auto a = std::chrono::steady_clock::now();
+			 bool result = __LoadData(buf, buf_len, imple, token_arr_start, token_arr_len, _global, 0, 0, next, count_vec, err, no, pool);
+			 *time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - a).count();
+			 return result;
+		 }
+
 		 int64_t FindDivisionPlace(char* buf, _simdjson::internal::dom_parser_implementation* imple, int64_t start, int64_t last)
 		{
 			for (int64_t a = start; a <= last; ++a) {
@@ -1832,115 +2187,550 @@ namespace claujson {
 			}
 			return -1;
 		}
-		 // _global_memory_pool is not nullptr
-		 bool _LoadData(_Value& global, Arena* _global_memory_pool, char* buf, uint64_t buf_len,
-
-			_simdjson::internal::dom_parser_implementation* imple, int64_t& length,
-			my_vector<int64_t>& start, uint64_t* count_vec,
+		// divide blocks of _global_memory_pool to n Arenas.
+		 std::vector<Arena*> DividePool(Arena* _global_memory_pool, uint64_t n) {
+			std::vector<std::vector<BlockManager<Arena::Block>>> divided = _global_memory_pool->DivideBlock();
+			std::vector<Arena*> memory_pool(n);
+			uint64_t i = 0;
+			for (auto*& x : memory_pool) {
+				if (i < divided[0].size()) {
+					x = new Arena(divided[0][i].start_block, divided[0][i].last_block, 
+						divided[1][i].start_block, divided[1][i].last_block);
+				}
+				else {
+					x = new Arena();
+				}
+				x->EnableKeyIntern(_global_memory_pool->IsKeyIntern());
+				x->EnableShapeShare(_global_memory_pool->IsShapeShare());
+				x->EnableLazy(_global_memory_pool->IsLazy());
+				x->EnableZeroCopy(_global_memory_pool->IsZeroCopy());
+				x->SetInput(_global_memory_pool->GetInput(), _global_memory_pool->GetInputSize());
+				x->SetPageMode(_global_memory_pool->GetPageMode());
+				++i;
+			}
+			return memory_pool;
+		}
 
-			 uint64_t parse_num) // first, strVec.empty() must be true!!
-		{	
-			StructuredPtr _global = (new PartialJson(_global_memory_pool));
-			my_vector<StructuredPtr> __global;
-			std::vector<Arena*> memory_pool;
+		 static void SetParents(StructuredPtr target, uint64_t from, uint64_t to) {
+			 for (uint64_t i = from; i < to; ++i) {
+				 _Value& x = target.get_value_list(i);
+				 if (x.is_structured()) {
+					 StructuredPtr y = x;
+					 y.set_parent(target);
+				 }
+			 }
+		 }
 
-			try {
-				 
-				{
-					uint64_t pivot_num = parse_num;
-					
-					{ 
-					std::set<int64_t> _pivots;
-					my_vector<int64_t> pivots;
-					//const int64_t num = token_arr_len; //
+		 // exact size of targets in parent_jobs, (containers over parts) and set parent of items in them, in parallel.
+		 void UpdateParents() {
+			 const uint64_t chunk = 1 << 16;
 
-					if (pivot_num > 0) {
-						my_vector<int64_t> pivot;
-						pivots.reserve(pivot_num + 1);
-						pivot.reserve(pivot_num);
+			 uint64_t total = 0;
+			 for (const auto& job : parent_jobs) {
+				 StructuredPtr target = job.target;
+				 target.shrink_data_list(); // it is no-op if reserved with count.
+				 total += job.to - job.from;
+			 }
 
-						pivot.push_back(start[0]);
+			 if (total <= chunk) { // on this thread, no tasks.
+				 for (const auto& job : parent_jobs) {
+					 SetParents(job.target, job.from, job.to);
+				 }
+				 parent_jobs.clear();
+				 return;
+			 }
 
-						for (uint64_t i = 1; i < parse_num; ++i) {
-							pivot.push_back(FindDivisionPlace(buf, imple, start[i], start[i + 1] - 1));
-						}
+			 std::vector<std::future<void>> result;
 
-						for (uint64_t i = 0; i < pivot.size(); ++i) {
-							if (pivot[i] != -1) {
-								_pivots.insert(pivot[i]);
-							}
-						}
+			 for (const auto& job : parent_jobs) {
+				 for (uint64_t from = job.from; from < job.to; from += chunk) {
+					 const uint64_t to = std::min(job.to, from + chunk);
+					 StructuredPtr target = job.target;
+					 result.push_back(pool->enqueue([target, from, to]() {
+						 SetParents(target, from, to);
+					 }));
+				 }
+			 }
+			 for (auto& x : result) {
+				 x.get();
+			 }
+			 parent_jobs.clear();
+		 }
 
-						for (auto& x : _pivots) {
-							pivots.push_back(x);
-						}
+		// items of one level of a part -> [offset, offset + len) of target.
+		struct MoveJob {
+			StructuredPtr target; // Array or Object, (or _global, PartialJson)
+			StructuredPtr from; // virtual Array or Object, or PartialJson. (top of part)
+			uint64_t skip; // 1 if first item of from is virtual. (deeper level)
+			uint64_t offset;
+			uint64_t len;
+		};
 
-						pivots.push_back(length);
+		// move items [a, b) of job, and set parent of them.
+		static void MoveItems(const MoveJob& job, uint64_t a, uint64_t b) {
+			StructuredPtr target = job.target;
+			if (target.type == 1) {
+				_Value* src = (job.from.type == 1 ? job.from.arr->arr_vec.begin() : job.from.pj->arr_vec.begin()) + job.skip;
+				_Value* dst = target.arr->arr_vec.begin() + job.offset;
+				for (uint64_t k = a; k < b; ++k) {
+					new (dst + k) _Value(std::move(src[k]));
+					if (dst[k].is_structured()) {
+						StructuredPtr y = dst[k];
+						y.set_parent(target);
 					}
-					else {
-						pivots.push_back(start[0]);
-						pivots.push_back(length);
+				}
+			}
+			else {
+				Pair<_Value, _Value>* src = (job.from.type == 2 ? job.from.obj->obj_data.begin() : job.from.pj->obj_data.begin()) + job.skip;
+				Pair<_Value, _Value>* dst = target.obj->obj_data.begin() + job.offset;
+				for (uint64_t k = a; k < b; ++k) {
+					new (dst + k) Pair<_Value, _Value>(std::move(src[k].first), std::move(src[k].second));
+					if (dst[k].second.is_structured()) {
+						StructuredPtr y = dst[k].second;
+						y.set_parent(target);
 					}
+				}
+			}
+		}
 
-					my_vector<StructuredPtr> next(pivots.size() - 1);
-					{
-						std::vector<std::vector<BlockManager<Arena::Block>>> divided = _global_memory_pool->DivideBlock();
-						memory_pool = std::vector<Arena*>(pivots.size() - 1);
-						uint64_t i = 0;
-						for (auto*& x : memory_pool) {
-							if (i < divided[0].size()) {
-								x = new Arena(divided[0][i].start_block, divided[0][i].last_block, 
-									divided[1][i].start_block, divided[1][i].last_block);
-							}
-							else {
-								x = new Arena();
-							}
-							++i;
-						}
+		// keys of tree of top -> shared copy in table of root, if found.
+		static void RemapKeys(StructuredPtr top, const Arena* root) {
+			std::vector<StructuredPtr> stack{ top };
+			while (!stack.empty()) {
+				StructuredPtr x = stack.back();
+				stack.pop_back();
 
-						__global = my_vector<StructuredPtr>(pivots.size() - 1);
-						for (uint64_t i = 0; i < __global.size(); ++i) {
-							__global[i] = (new PartialJson(memory_pool[i]));
-						}
+				if (x.type == 2 || x.type == 3) {
+					auto& obj_data = x.type == 2 ? x.obj->obj_data : x.pj->obj_data;
+					for (uint64_t k = 0; k < obj_data.size(); ++k) {
+						obj_data[k].first.remap_key(root);
+					}
+				}
+				const uint64_t len = x.get_data_size();
+				for (uint64_t k = 0; k < len; ++k) {
+					_Value& y = x.get_value_list(k);
+					if (y.is_structured()) {
+						stack.push_back(y);
+					}
+				}
+			}
+		}
 
-						my_vector<std::future<bool>> result(pivots.size() - 1);
-						my_vector<int> err(pivots.size() - 1);
-						
-						
+		// key interning, tables of parts -> table of root, (serial) then keys of parts -> one copy, (in parallel)
+		// and other copies go back to Arena of their part. (link_from has nothing to merge)
+		void MergeKeys(my_vector<StructuredPtr>& __global, std::vector<Arena*>& memory_pool, Arena* root,
+			uint64_t start, uint64_t last, const my_vector<int>& chk) {
+			std::vector<std::vector<KeyTable::Entry>> copies(last + 1);
+			for (uint64_t i = start; i <= last; ++i) {
+				if (!chk[i]) {
+					root->merge_keys(memory_pool[i], &copies[i]);
+				}
+			}
 
-						{
-							int64_t idx = pivots[1] - pivots[0];
-							int64_t _token_arr_len = idx;
+			std::vector<std::future<void>> result;
+			for (uint64_t i = start; i <= last; ++i) {
+				if (copies[i].empty()) {
+					continue;
+				}
+				StructuredPtr top = __global[i];
+				Arena* a = memory_pool[i];
+				const std::vector<KeyTable::Entry>* c = &copies[i];
+				result.push_back(pool->enqueue([top, a, c, root]() {
+					RemapKeys(top, root);
+					for (const auto& x : *c) {
+						a->deallocate<char>(x.str, static_cast<uint64_t>(x.sz) + 1);
+					}
+				}));
+			}
+			for (auto& x : result) {
+				x.get();
+			}
+		}
 
+		// link arenas pairwise, (log depth, on pool) and then to root.
+		void LinkAll(Arena* root, std::vector<Arena*>& arenas) {
+			for (uint64_t step = 1; step < arenas.size(); step *= 2) {
+				std::vector<std::future<void>> result;
+				for (uint64_t i = 0; i + step < arenas.size(); i += 2 * step) {
+					Arena* a = arenas[i];
+					Arena* b = arenas[i + step];
+					if (arenas.size() <= 2 * step) { // last pair, on this thread.
+						a->link_from(b);
+					}
+					else {
+						result.push_back(pool->enqueue([a, b]() { a->link_from(b); }));
+					}
+				}
+				for (auto& x : result) {
+					x.get();
+				}
+			}
+			if (!arenas.empty()) {
+				root->link_from(arenas[0]);
+			}
+		}
 
-							result[0] = pool->enqueue(__LoadData, (buf), buf_len, (imple), start[0], _token_arr_len, (__global[0]), 0, 0,
-								&next[0], count_vec,
+		// merge __global[i] (with next[i]) to _global, and link memory_pool to _global_memory_pool. throw int
+		// 1. plan, (serial, only levels of parts) level l of part i goes to l-th open container (from innermost) at start of part i.
+		// 2. key interning -> keys of parts share copies in table of _global_memory_pool. (MergeKeys)
+		// 3. each target is extended once to exact size, and items of all parts are moved to their place in parallel.
+		// 4. arenas are linked pairwise in parallel.
+		 void MergeAll(StructuredPtr& _global, my_vector<StructuredPtr>& __global, my_vector<StructuredPtr>& next, 
+			 std::vector<Arena*>& memory_pool, Arena* _global_memory_pool) {
+			parent_jobs.clear();
 
-								&err[0], 0, memory_pool[0]);
-						}
+			const uint64_t part_num = __global.size();
+			uint64_t start = part_num;
+			uint64_t last = part_num;
 
-						auto a = std::chrono::steady_clock::now();
+			// open containers, [0] is _global. (container, idx of its jobs or -1)
+			std::vector<std::pair<StructuredPtr, int64_t>> stack;
+			std::vector<std::vector<MoveJob>> jobs; // jobs[k] : jobs of same target, in order of parts.
+			std::vector<StructuredPtr> level; // level[0] : innermost virtual, level.back() : top of part (PartialJson)
+			my_vector<int> chk(part_num); // 1 : empty part.
 
-						for (uint64_t i = 1; i < pivots.size() - 1; ++i) {
-							int64_t _token_arr_len = pivots[i + 1] - pivots[i];
+			stack.push_back({ _global, -1 });
 
-							result[i] = pool->enqueue(__LoadData, (buf), buf_len, (imple), pivots[i], _token_arr_len, (__global[i]), 0, 0,
-								&next[i], count_vec,
+			for (uint64_t i = 0; i < part_num; ++i) {
+				chk[i] = __global[i].get_data_size() == 0;
+				if (chk[i]) {
+					continue;
+				}
+				if (start == part_num) {
+					start = i;
+				}
+				last = i;
 
-								& err[i], i, memory_pool[i]);
+				level.clear();
+				for (StructuredPtr x = __global[i]; ; x = x.get_value_list(0)) {
+					level.push_back(x);
+					if (!(x.get_data_size() > 0 && x.get_value_list(0).is_structured() && x.get_value_list(0).is_virtual())) {
+						break;
+					}
+				}
+				std::reverse(level.begin(), level.end());
 
-						}
+				const uint64_t close_num = level.size() - 1;
 
+				if (i == start && close_num > 0) {
+					log << warn << "not valid file1\n";
+					throw 1;
+				}
+				if (close_num >= stack.size()) { // closes _global?
+					log << warn << "chk " << i << " " << part_num << "\n";
+					log << warn << "not valid file4\n";
+					throw 4;
+				}
 
-						// wait
-						for (uint64_t i = 0; i < result.size(); ++i) {
-							result[i].get();
-						}
+				for (uint64_t l = 0; l <= close_num; ++l) {
+					auto& target = stack[stack.size() - 1 - l];
+					StructuredPtr from = level[l];
+					uint64_t skip = 0;
+					uint64_t len = 0;
 
-						auto b = std::chrono::steady_clock::now();
+					if (l < close_num) {
+						if (target.first.is_array() != from.is_array()) {
+							ERROR("Error in Merge, next and child are not same type");
+						}
+						skip = l > 0 ? 1 : 0; // first item of level l is level l - 1.
+						len = from.get_data_size() - skip;
+					}
+					else {
+						if (target.first.is_array() && !from.pj->obj_data.empty()) {
+							ERROR("partial json is not array");
+						}
+						if (target.first.is_object() && !from.pj->arr_vec.empty()) {
+							ERROR("partial json is not object");
+						}
+						len = from.pj->arr_vec.size() + from.pj->obj_data.size();
+					}
+
+					if (target.second < 0) {
+						target.second = jobs.size();
+						jobs.emplace_back();
+					}
+					jobs[target.second].push_back({ target.first, from, skip, 0, len });
+				}
+
+				stack.resize(stack.size() - close_num);
+
+				// open containers of this part, top to next[i].
+				const uint64_t base = stack.size();
+				for (StructuredPtr x = next[i]; x && !(x == level.back()); x = x.get_parent()) {
+					stack.insert(stack.begin() + base, { x, -1 });
+				}
+			}
+
+			if (start == part_num) {
+				log << warn << "not valid file3\n";
+				throw 3;
+			}
+			if (stack.size() != 1) {
+				log << warn << "not valid file5\n";
+				throw 5;
+			}
+
+			// root value, checked before tables of parts are merged. (no throw after it)
+			for (const auto& group : jobs) {
+				if (group[0].target.type != 3) {
+					continue;
+				}
+				uint64_t n = group[0].target.get_data_size();
+				for (const auto& job : group) {
+					n += job.from.pj->arr_vec.size();
+				}
+				if (n > 1) {
+					log << warn << "not valid file6\n";
+					throw 6;
+				}
+			}
+
+			if (_global_memory_pool->IsKeyIntern()) {
+				MergeKeys(__global, memory_pool, _global_memory_pool, start, last, chk);
+			}
+
+			// exact size of targets, (one allocation for each target) and places of items.
+			uint64_t total = 0;
+			for (auto& group : jobs) {
+				StructuredPtr target = group[0].target;
+				if (target.type == 3) { // _global, root value.
+					for (auto& job : group) {
+						target.MergeWith(job.from, 0, true);
+						job.len = 0;
+					}
+					if (target.get_data_size() > 1) { // bug fix..
+						log << warn << "not valid file6\n";
+						throw 6;
+					}
+					continue;
+				}
+
+				uint64_t n = 0;
+				for (const auto& job : group) {
+					n += job.len;
+				}
+				uint64_t offset = target.get_data_size();
+				if (target.type == 1) {
+					target.arr->arr_vec.extend(n);
+				}
+				else {
+					target.obj->drop_index();
+					target.obj->obj_data.extend(n);
+				}
+				for (auto& job : group) {
+					job.offset = offset;
+					offset += job.len;
+				}
+				total += n;
+			}
+
+			// move items, in parallel.
+			{
+				const uint64_t chunk = 1 << 16;
+
+				if (total <= chunk) { // on this thread, no tasks.
+					for (const auto& group : jobs) {
+						for (const auto& job : group) {
+							MoveItems(job, 0, job.len);
+						}
+					}
+				}
+				else {
+					std::vector<std::future<void>> result;
+					for (const auto& group : jobs) {
+						for (const auto& job : group) {
+							for (uint64_t a = 0; a < job.len; a += chunk) {
+								const uint64_t b = std::min(job.len, a + chunk);
+								const MoveJob* p = &job;
+								result.push_back(pool->enqueue([p, a, b]() { MoveItems(*p, a, b); }));
+							}
+						}
+					}
+					for (auto& x : result) {
+						x.get();
+					}
+				}
+			}
+
+			for (auto& group : jobs) {
+				for (const auto& job : group) {
+					StructuredPtr from = job.from; // items are moved, not destructed.
+					from.clear();
+				}
+				StructuredPtr target = group[0].target;
+				target.shrink_data_list(); // it is no-op if reserved with count.
+				if (target.is_object() && target.get_data_size() >= Object::index_threshold) {
+					target.obj->build_index();
+				}
+			}
+
+			std::vector<Arena*> arenas;
+			for (uint64_t i = start; i <= last; ++i) {
+				if (chk[i]) { delete memory_pool[i]; memory_pool[i] = nullptr; continue; }
+				arenas.push_back(memory_pool[i]);
+				memory_pool[i] = nullptr;
+			}
+			LinkAll(_global_memory_pool, arenas);
+		}
+
+		 // one part -> __LoadData on this thread in _global_memory_pool, and merge to _global.
+		 // (no worker Arenas, tasks and futures, same checks to MergeAll with one part) throw int
+		 void LoadOnePart(StructuredPtr& _global, char* buf, uint64_t buf_len, _simdjson::internal::dom_parser_implementation* imple,
+			 int64_t token_arr_start, uint64_t token_arr_len, uint64_t* count_vec, Arena* _global_memory_pool) {
+			 parent_jobs.clear();
+			 imbalance = 1.0;
+
+			 StructuredPtr part = (new PartialJson(_global_memory_pool));
+			 try {
+				 StructuredPtr next;
+				 int err = 0;
+				 if (!__LoadData(buf, buf_len, imple, token_arr_start, token_arr_len, part, 0, 0, &next, count_vec, &err, 0, _global_memory_pool)) {
+					 throw err;
+				 }
+
+				 if (part.get_data_size() > 0 && part.get_value_list(0).is_structured()
+					 && (part.get_value_list(0).is_virtual())) {
+					 log << warn << "not valid file1\n";
+					 throw 1;
+				 }
+				 if (next && !(next.get_parent() == nullptr)) {
+					 log << warn << "not valid file2\n";
+					 throw 2;
+				 }
+				 if (-1 == Merge(_global, part, &next)) {
+					 log << warn << "not valid file3\n";
+					 throw 3;
+				 }
+				 if (_global.get_data_size() > 1) {
+					 log << warn << "not valid file6\n";
+					 throw 6;
+				 }
+
+				 UpdateParents();
+			 }
+			 catch (...) {
+				 part.Delete();
+				 throw;
+			 }
+			 part.Delete();
+		 }
+
+		 // _global_memory_pool is not nullptr
+		 bool _LoadData(_Value& global, Arena* _global_memory_pool, char* buf, uint64_t buf_len,
+
+			_simdjson::internal::dom_parser_implementation* imple, int64_t& length,
+			my_vector<int64_t>& start, uint64_t* count_vec,
+
+			 uint64_t parse_num) // first, strVec.empty() must be true!!
+		{	
+			StructuredPtr _global = (new PartialJson(_global_memory_pool));
+			my_vector<StructuredPtr> __global;
+			std::vector<Arena*> memory_pool;
+
+			try {
+				 
+				{
+					uint64_t pivot_num = parse_num;
+					
+					if (pivot_num <= 1) { // ex) tiny str.
+						LoadOnePart(_global, buf, buf_len, imple, start[0], length - start[0], count_vec, _global_memory_pool);
+					}
+					else { 
+					std::set<int64_t> _pivots;
+					my_vector<int64_t> pivots;
+					//const int64_t num = token_arr_len; //
+
+					if (pivot_num > 0) {
+						my_vector<int64_t> pivot;
+						pivots.reserve(pivot_num + 1);
+						pivot.reserve(pivot_num);
+
+						pivot.push_back(start[0]);
+
+						for (uint64_t i = 1; i < parse_num; ++i) {
+							pivot.push_back(FindDivisionPlace(buf, imple, start[i], start[i + 1] - 1));
+						}
+
+						for (uint64_t i = 0; i < pivot.size(); ++i) {
+							if (pivot[i] != -1) {
+								_pivots.insert(pivot[i]);
+							}
+						}
+
+						for (auto& x : _pivots) {
+							pivots.push_back(x);
+						}
+
+						pivots.push_back(length);
+					}
+					else {
+						pivots.push_back(start[0]);
+						pivots.push_back(length);
+					}
+
+					my_vector<StructuredPtr> next(pivots.size() - 1);
+					{
+						memory_pool = DividePool(_global_memory_pool, pivots.size() - 1);
+
+						__global = my_vector<StructuredPtr>(pivots.size() - 1);
+						for (uint64_t i = 0; i < __global.size(); ++i) {
+							__global[i] = (new PartialJson(memory_pool[i]));
+						}
+						if (item_num.size() == __global.size()) {
+							for (uint64_t i = 0; i < __global.size(); ++i) {
+								__global[i].pj->item_num = item_num[i];
+							}
+						}
+
+						my_vector<std::future<bool>> result(pivots.size() - 1);
+						my_vector<int> err(pivots.size() - 1);
+						my_vector<uint64_t> part_time(pivots.size() - 1);
+						
+						
+
+						{
+							int64_t idx = pivots[1] - pivots[0];
+							int64_t _token_arr_len = idx;
+
+
+							result[0] = pool->enqueue(__TimedLoadData, (buf), buf_len, (imple), start[0], _token_arr_len, (__global[0]),
+								&next[0], count_vec,
+
+								&err[0], 0, memory_pool[0], &part_time[0]);
+						}
+
+						auto a = std::chrono::steady_clock::now();
+
+						for (uint64_t i = 1; i < pivots.size() - 1; ++i) {
+							int64_t _token_arr_len = pivots[i + 1] - pivots[i];
+
+							result[i] = pool->enqueue(__TimedLoadData, (buf), buf_len, (imple), pivots[i], _token_arr_len, (__global[i]),
+								&next[i], count_vec,
+
+								& err[i], i, memory_pool[i], &part_time[i]);
+
+						}
+
+
+						// wait
+						for (uint64_t i = 0; i < result.size(); ++i) {
+							result[i].get();
+						}
+
+						auto b = std::chrono::steady_clock::now();
 						auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
 						log << info << "parse1 " << dur.count() << "ms\n";
 
+						{
+							uint64_t sum = 0, max = 0;
+							for (auto x : part_time) {
+								sum += x;
+								max = std::max(max, x);
+							}
+							imbalance = sum > 0 ? (double)max * part_time.size() / sum : 1.0;
+							log << info << "parse1 imbalance (slowest / average) " << imbalance << "\n";
+						}
+
 						// check..
 						for (uint64_t i = 0; i < err.size(); ++i) {
 							switch (err[i]) {
@@ -1972,99 +2762,7 @@ namespace claujson {
 						}
 
 						// Merge
-
-						{
-							int i = 0;
-							my_vector<int> chk(parse_num);
-							auto x = next.begin();
-							auto y = __global.begin();
-							while (true) {
-								if ((y)->get_data_size() == 0) {
-									chk[i] = 1;
-								}
-
-								++x;
-								++y;
-								++i;
-
-								if (x == next.end()) {
-									break;
-								}
-							}
-
-							uint64_t start = 0;
-							uint64_t last = pivots.size() - 1 - 1;
-
-							for (uint64_t i = 0; i < pivots.size() - 1; ++i) {
-								if (chk[i] == 0) {
-									start = i;
-									break;
-								}
-							}
-
-							for (uint64_t i = pivots.size() - 1; i > 0; --i) {
-								if (chk[i - 1] == 0) {
-									last = i - 1;
-									break;
-								}
-							}
-
-							if (__global[start].get_data_size() > 0 && __global[start].get_value_list(0).is_structured()
-								&& (__global[start].get_value_list(0).is_virtual())) {
-								log << warn << "not valid file1\n";
-								throw 1;
-							}
-							if (next[last] && !(next[last].get_parent() == nullptr)) {
-								log << warn << "not valid file2\n";
-								throw 2;
-							}
-
-
-							int err = Merge(_global, __global[start], &next[start]);
-							if (-1 == err || (pivots.size() == 0 && 1 == err)) {
-								log << warn << "not valid file3\n";
-								throw 3;
-							}
-
-							for (uint64_t i = start + 1; i <= last; ++i) {
-
-								if (chk[i]) {
-									continue;
-								}
-
-								// linearly merge and error check...
-								uint64_t before = i - 1;
-								for (uint64_t k = i; k > 0; --k) {
-									if (chk[k - 1] == 0) {
-										before = k - 1;
-										break;
-									}
-								}
-
-								int err = Merge(next[before], __global[i], &next[i]);
-
-								if (-1 == err) {
-									log << warn << "chk " << i << " " << __global.size() << "\n";
-									log << warn << "not valid file4\n";
-									throw 4;
-								}
-								else if (i == last && 1 == err) {
-									log << warn << "not valid file5\n";
-									throw 5;
-								}
-							}
-
-							if (_global.get_data_size() > 1) { // bug fix..
-								log << warn << "not valid file6\n";
-								throw 6;
-							}
-
-							_global_memory_pool->link_from(memory_pool[start]);
-							for (uint64_t i = start + 1; i <= last; ++i) {
-								if (chk[i]) { delete memory_pool[i]; memory_pool[i] = nullptr; continue; }
-								_global_memory_pool->link_from(memory_pool[i]);
-							}	
-						}
+						MergeAll(_global, __global, next, memory_pool, _global_memory_pool);
 						//catch (...) {
 							//throw "in Merge, error";
 						//	return false;
@@ -2181,54 +2879,435 @@ namespace claujson {
 				thr_num);
 		}
 
-	private:
-		//                         
-		 static void _write(StrStream& stream, const _Value& data, my_vector<StructuredPtr>& chk_list, const int depth, bool pretty);
-		 static void _write(StrStream& stream, const _Value& data, const int depth, bool pretty);
+		 // is_valid2 + __LoadData for one part.
+		 // count of containers of this part -> count_vec[0, ...), is_valid2 reads at most 2 tokens after last.
+		 static bool __ValidAndLoadData(char* buf, uint64_t buf_len,
+			 _simdjson::internal::dom_parser_implementation* imple,
+			 uint64_t token_arr_start, uint64_t token_arr_len, uint64_t last, StructuredPtr _global,
+			 int* start_state, int* last_state, Vector<int8_t>* is_array, Vector<int8_t>* is_virtual_array,
+			 class StructuredPtr* next, int* err, uint64_t no, Arena* pool)
+		 {
+			 uint64_t* count_vec = (uint64_t*)malloc(sizeof(uint64_t) * (last - token_arr_start + 4));
+			 if (!count_vec) {
+				 log << warn << "malloc fail in __ValidAndLoadData function.";
+				 return false;
+			 }
+			 if (!is_valid2(buf, imple, token_arr_start, last, start_state, last_state, is_array, is_virtual_array, count_vec, false,
+				 nullptr, nullptr, token_arr_start)) {
+				 free(count_vec);
+				 return false;
+			 }
+			 __LoadData(buf, buf_len, imple, token_arr_start, token_arr_len, _global, 0, 0, next, count_vec, err, no, pool, token_arr_start);
+			 free(count_vec);
+			 return true;
+		 }
 
-		 static void write_(StrStream& stream, const _Value& global, StructuredPtr temp, bool pretty, bool hint);
+		 // is_valid2 + __LoadData for values [first, last), value i is tokens [value_start[i], value_end[i]).
+		 // with_key -> value is "key" : value. (count_vec is used from value_start + 2)
+		 static bool __LoadValues(char* buf, uint64_t buf_len,
+			 _simdjson::internal::dom_parser_implementation* imple,
+			 const int64_t* value_start, const int64_t* value_end, uint64_t first, uint64_t last, bool with_key,
+			 StructuredPtr _global, uint64_t* count_vec, int* err, Arena* pool)
+		 {
+			 const uint32_t* tokens = imple->structural_indexes.get();
 
-	public:
-		// test?... just Data has one element 
-		 void write(const std::string& fileName, const _Value& global, bool pretty, bool hint = false);
+			 for (uint64_t i = first; i < last; ++i) {
+				 int start_state = 0;
+				 int last_state = 0;
+				 const int64_t offset = with_key ? 2 : 0;
 
-		 void write(std::ostream& stream, const _Value& data, bool pretty);
+				 if (value_end[i] - value_start[i] <= offset) {
+					 *err = -1;
+					 return false;
+				 }
+				 if (with_key && (buf[tokens[value_start[i]]] != '"' || buf[tokens[value_start[i] + 1]] != ':')) {
+					 *err = -1;
+					 return false;
+				 }
+				 if (!is_valid2(buf, imple, value_start[i] + offset, value_end[i] - 1, &start_state, &last_state,
+					 nullptr, nullptr, count_vec, true)) {
+					 *err = -1;
+					 return false;
+				 }
+				 if (!__LoadData(buf, buf_len, imple, value_start[i], value_end[i] - value_start[i], _global, 0, 0,
+					 nullptr, count_vec + offset, err, i, pool)) {
+					 if (*err == 0) {
+						 *err = -1;
+					 }
+					 return false;
+				 }
+			 }
+			 return true;
+		 }
 
-		 std::string write_to_str(const _Value& data, bool pretty);
-		 std::string write_to_str2(const _Value& data, bool pretty);
+		 // values -> __global[i] (memory_pool[i] from _global_memory_pool), parts are divided by number of tokens.
+		 // after use, __global[i].Delete(), and link_from(memory_pool[i]) (or delete memory_pool[i])
+		 bool LoadValues(Arena* _global_memory_pool, char* buf, uint64_t buf_len,
+			 _simdjson::internal::dom_parser_implementation* imple,
+			 const int64_t* value_start, const int64_t* value_end, uint64_t value_num, bool with_key,
+			 uint64_t* count_vec, uint64_t thr_num, my_vector<StructuredPtr>& __global, std::vector<Arena*>& memory_pool)
+		 {
+			 const int64_t first_token = value_start[0];
+			 const int64_t length = value_end[value_num - 1] - first_token;
+
+			 // values of part i : [part[i], part[i+1])
+			 my_vector<uint64_t> part;
+			 part.push_back(0);
+			 for (uint64_t i = 1; i < thr_num; ++i) {
+				 const int64_t* x = std::lower_bound(value_start, value_start + value_num, first_token + (int64_t)(length / thr_num * i));
+				 uint64_t idx = x - value_start;
+				 if (idx > part.back() && idx < value_num) {
+					 part.push_back(idx);
+				 }
+			 }
+			 part.push_back(value_num);
 
-		 void write_parallel(Arena* pool, const std::string& fileName, _Value& j, uint64_t thr_num, bool pretty);
-		 void write_parallel2(const std::string& fileName, const _Value& j, uint64_t thr_num, bool pretty);
+			 const uint64_t part_num = part.size() - 1;
 
-	};
+			 memory_pool = DividePool(_global_memory_pool, part_num);
+			 __global = my_vector<StructuredPtr>(part_num);
+			 my_vector<std::future<bool>> result(part_num);
+			 my_vector<int> err(part_num);
 
-	claujson_inline void _write_string(StrStream& stream, char ch) {
-		switch (ch) {
-		case '\\':
-			stream.add_2("\\\\");
-			break;
-		case '\"':
-			stream.add_2("\\\"");
-			break;
-		case '\n':
-			stream.add_2("\\n");
-			break;
-		case '\b':
-			stream.add_2("\\b");
-			break;
-		case '\f':
-			stream.add_2("\\f");
-			break;
-		case '\r':
-			stream.add_2("\\r");
-			break;
-		case '\t':
-			stream.add_2("\\t");
-			break;
-		default:
-		{
-			int code = ch;
-			if ((code >= 0 && code < 0x20) || code == 0x7F)
+			 for (uint64_t i = 0; i < part_num; ++i) {
+				 __global[i] = (new PartialJson(memory_pool[i]));
+			 }
+
+			 for (uint64_t i = 0; i < part_num; ++i) {
+				 result[i] = pool->enqueue(__LoadValues, buf, buf_len, imple, value_start, value_end, part[i], part[i + 1], with_key,
+					 __global[i], count_vec, &err[i], memory_pool[i]);
+			 }
+
+			 bool ok = true;
+			 for (uint64_t i = 0; i < part_num; ++i) {
+				 if (!result[i].get()) {
+					 ok = false;
+				 }
+			 }
+
+			 if (!ok) {
+				 for (uint64_t i = 0; i < part_num; ++i) {
+					 if (err[i] != 0) {
+						 log << warn << "not valid value, err " << err[i] << "\n";
+						 break;
+					 }
+				 }
+			 }
+
+			 return ok;
+		 }
+
+		 static void FreeValues(Arena* _global_memory_pool, my_vector<StructuredPtr>& __global, std::vector<Arena*>& memory_pool, bool link) {
+			 for (uint64_t i = 0; i < __global.size(); ++i) {
+				 __global[i].Delete();
+				 if (link) {
+					 _global_memory_pool->link_from(memory_pool[i]);
+				 }
+				 else {
+					 delete memory_pool[i];
+				 }
+			 }
+		 }
+
+		 // line_start : first token of lines, line_start.back() is length. -> global is array of lines.
+		 bool parse_ndjson(_Value& global, Arena* _global_memory_pool, char* buf, uint64_t buf_len,
+			 _simdjson::internal::dom_parser_implementation* imple,
+			 const my_vector<int64_t>& line_start, uint64_t* count_vec, uint64_t thr_num)
+		 {
+			 const uint64_t line_num = line_start.size() - 1;
+
+			 my_vector<StructuredPtr> __global;
+			 std::vector<Arena*> memory_pool;
+
+			 auto a = std::chrono::steady_clock::now();
+
+			 bool ok = LoadValues(_global_memory_pool, buf, buf_len, imple, &line_start[0], &line_start[1], line_num, false,
+				 count_vec, thr_num, __global, memory_pool);
+
+			 auto b = std::chrono::steady_clock::now();
+			 auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+			 log << info << "parse1 " << dur.count() << "ms\n";
+
+			 if (ok) {
+				 global = Array::Make(_global_memory_pool);
+
+				 StructuredPtr arr = global;
+				 arr.reserve_data_list(line_num);
+
+				 for (uint64_t i = 0; i < __global.size(); ++i) {
+					 const uint64_t len = __global[i].get_data_size();
+					 for (uint64_t j = 0; j < len; ++j) {
+						 arr.add_array_element(std::move(__global[i].get_value_list(j)));
+					 }
+				 }
+			 }
+
+			 FreeValues(_global_memory_pool, __global, memory_pool, ok);
+
+			 return ok;
+		 }
+
+		 // values of root (array or object) -> callback(key, value) in order, ++value_count. (key is NONE if !with_key)
+		 // memory of values is linked to _global_memory_pool, (caller calls Reset for next values.)
+		 bool parse_values(Arena* _global_memory_pool, char* buf, uint64_t buf_len,
+			 _simdjson::internal::dom_parser_implementation* imple,
+			 const my_vector<int64_t>& value_start, const my_vector<int64_t>& value_end, bool with_key,
+			 uint64_t* count_vec, uint64_t thr_num, const std::function<bool(_Value&, _Value&)>& callback, uint64_t& value_count, bool& stop)
+		 {
+			 my_vector<StructuredPtr> __global;
+			 std::vector<Arena*> memory_pool;
+
+			 bool ok = LoadValues(_global_memory_pool, buf, buf_len, imple, &value_start[0], &value_end[0], value_start.size(), with_key,
+				 count_vec, thr_num, __global, memory_pool);
+
+			 if (ok) {
+				 _Value no_key;
+				 for (uint64_t i = 0; i < __global.size() && !stop; ++i) {
+					 const uint64_t len = __global[i].get_data_size();
+					 for (uint64_t j = 0; j < len; ++j) {
+						 _Value& value = __global[i].get_value_list(j);
+						 if (value.is_structured()) {
+							 StructuredPtr x = value;
+							 x.set_parent({});
+						 }
+						 ++value_count;
+						 if (!callback(with_key ? __global[i].get_key_list(j) : no_key, value)) {
+							 stop = true;
+							 break;
+						 }
+					 }
+				 }
+			 }
+
+			 FreeValues(_global_memory_pool, __global, memory_pool, ok);
+
+			 return ok;
+		 }
+
+		 // stage1 for chunk of buf (chunk_imple) -> copy to imple->structural_indexes,
+		 // parts of completed chunks -> is_valid2 + __LoadData, while stage1 of next chunk.
+		 // chunk ends with ',' (out of string), so part is [',' ~ ',').
+		 bool parse_pipelined(_Value& global, Arena* _global_memory_pool, char* buf, uint64_t buf_len,
+			_simdjson::internal::dom_parser_implementation* imple,
+			_simdjson::internal::dom_parser_implementation* chunk_imple, uint64_t chunk_size, int64_t& length)
+		 {
+			 const uint64_t max_part = buf_len / chunk_size + 2;
+
+			 uint32_t* tokens = imple->structural_indexes.get();
+			 // not final value, while stage1. parts do not read tokens over their next part's first tokens.
+			 imple->n_structural_indexes = static_cast<uint32_t>(buf_len + 1);
+
+			 my_vector<uint64_t> start; // start of parts (',' except first)
+			 my_vector<int> start_state(max_part), last_state(max_part);
+			 for (uint64_t i = 0; i < max_part; ++i) {
+				 start_state[i] = -1;
+				 last_state[i] = -1;
+			 }
+			 my_vector<Vector<int8_t>> is_array(max_part), is_virtual_array(max_part);
+			 my_vector<StructuredPtr> __global(max_part), next(max_part);
+			 my_vector<std::future<bool>> result(max_part);
+			 my_vector<int> err(max_part);
+			 std::vector<Arena*> memory_pool = DividePool(_global_memory_pool, max_part);
+
+			 start.push_back(0);
+
+			 uint64_t n = 0;
+			 uint64_t dispatched = 1; // part 0 -> after stage1 (chk first and last token)
+			 bool stage1_ok = true;
+
+			 auto enqueue = [&](uint64_t i, uint64_t part_end, uint64_t last) {
+				 __global[i] = (new PartialJson(memory_pool[i]));
+				 result[i] = pool->enqueue(__ValidAndLoadData, buf, buf_len, imple, start[i], part_end - start[i], last, __global[i],
+					 &start_state[i], &last_state[i], &is_array[i], &is_virtual_array[i],
+					 &next[i], &err[i], i, memory_pool[i]);
+			 };
+
+			 auto a = std::chrono::steady_clock::now();
+
+			 uint64_t offset = 0;
+			 while (offset < buf_len) {
+				 uint64_t end = FindChunkEnd(buf, buf_len, offset + chunk_size);
+				 _simdjson::error_code e = stage1_chunk(chunk_imple, buf, buf_len, offset, &end);
+
+				 uint64_t chunk_n = 0;
+				 if (e == _simdjson::error_code::SUCCESS) {
+					 chunk_n = chunk_imple->n_structural_indexes;
+				 }
+				 else if (e != _simdjson::error_code::EMPTY) {
+					 log << warn << "stage1 error : ";
+					 log << warn << e << "\n";
+					 stage1_ok = false;
+					 break;
+				 }
+
+				 const uint32_t* chunk_tokens = chunk_imple->structural_indexes.get();
+				 for (uint64_t i = 0; i < chunk_n; ++i) {
+					 tokens[n + i] = chunk_tokens[i] + static_cast<uint32_t>(offset);
+				 }
+				 n += chunk_n;
+				 offset = end;
+
+				 if (end < buf_len) {
+					 if (n == 0 || tokens[n - 1] != end - 1) { // chk
+						 log << warn << "chunk does not end with ','\n";
+						 stage1_ok = false;
+						 break;
+					 }
+					 start.push_back(n - 1);
+				 }
+
+				 // next part's first tokens are needed. (is_valid2)
+				 while (dispatched + 1 < start.size() && start[dispatched + 1] + 3 <= n) {
+					 enqueue(dispatched, start[dispatched + 1], start[dispatched + 1]);
+					 ++dispatched;
+				 }
+			 }
+
+			 auto b = std::chrono::steady_clock::now();
+			 log << info << "stage1 (pipelined) " << std::chrono::duration_cast<std::chrono::milliseconds>(b - a).count() << "ms\n";
+
+			 const uint64_t part_num = start.size();
+			 bool valid = stage1_ok && n > 0;
+
+			 for (uint64_t i = 1; i < dispatched; ++i) {
+				 if (!result[i].get()) {
+					 valid = false;
+				 }
+			 }
+
+			 if (valid) {
+				 tokens[n] = static_cast<uint32_t>(buf_len);
+				 tokens[n + 1] = static_cast<uint32_t>(buf_len);
+				 tokens[n + 2] = 0;
+				 imple->n_structural_indexes = static_cast<uint32_t>(n);
+
+				 enqueue(0, part_num > 1 ? start[1] : n, part_num > 1 ? start[1] : n - 1);
+				 for (uint64_t i = dispatched; i < part_num; ++i) {
+					 enqueue(i, i + 1 < part_num ? start[i + 1] : n, i + 1 < part_num ? start[i + 1] : n - 1);
+				 }
+
+				 for (uint64_t i = 0; i < part_num; ++i) {
+					 if ((i == 0 || i >= dispatched) && !result[i].get()) {
+						 valid = false;
+					 }
+				 }
+			 }
+			 else if (n == 0 && stage1_ok) {
+				 log << warn << "empty string is not valid json";
+			 }
+
+			 auto c = std::chrono::steady_clock::now();
+			 log << info << "parse1 (pipelined) " << std::chrono::duration_cast<std::chrono::milliseconds>(c - b).count() << "ms\n";
+
+			 StructuredPtr _global = (new PartialJson(_global_memory_pool));
+
+			 try {
+				 if (!valid) {
+					 throw -1;
+				 }
+
+				 for (uint64_t i = 0; i < part_num; ++i) {
+					 if (err[i] != 0) {
+						 throw err[i];
+					 }
+				 }
+
+				 if (int e = is_valid2_merge(start_state, last_state, is_array, is_virtual_array, part_num)) {
+					 throw e;
+				 }
+
+				 my_vector<StructuredPtr> parts(part_num), parts_next(part_num);
+				 std::vector<Arena*> parts_pool(part_num);
+				 for (uint64_t i = 0; i < part_num; ++i) {
+					 parts[i] = __global[i];
+					 parts_next[i] = next[i];
+					 parts_pool[i] = memory_pool[i];
+				 }
+
+				 MergeAll(_global, parts, parts_next, parts_pool, _global_memory_pool);
+
+				 for (uint64_t i = 0; i < part_num; ++i) {
+					 memory_pool[i] = parts_pool[i]; // nullptr <- linked or deleted in MergeAll.
+				 }
+
+				 if (_global.get_value_list(0).is_structured()) {
+					 StructuredPtr x = _global.get_value_list(0);
+					 x.set_parent({});
+				 }
+
+				 global = std::move(_global.get_value_list(0));
+			 }
+			 catch (int e) {
+				 log << warn << "parse_pipelined error " << e << "\n";
+				 valid = false;
+			 }
+			 catch (...) {
+				 log << warn << "internal error or new error \n";
+				 valid = false;
+			 }
+
+			 for (uint64_t i = 0; i < max_part; ++i) {
+				 if (__global[i]) {
+					 __global[i].Delete();
+				 }
+				 if (memory_pool[i]) {
+					 delete memory_pool[i];
+				 }
+			 }
+			 _global.Delete();
+
+			 length = n;
+			 return valid;
+		 }
+
+	private:
+		//                         
+		 static void _write(StrStream& stream, const _Value& data, my_vector<StructuredPtr>& chk_list, const int depth, bool pretty);
+		 static void _write(StrStream& stream, const _Value& data, const int depth, bool pretty);
+
+		 static void write_(StrStream& stream, const _Value& global, StructuredPtr temp, bool pretty, bool hint);
+
+	public:
+		// test?... just Data has one element 
+		 void write(const std::string& fileName, const _Value& global, bool pretty, bool hint = false);
+
+		 void write(std::ostream& stream, const _Value& data, bool pretty);
+
+		 std::string write_to_str(const _Value& data, bool pretty);
+		 std::string write_to_str2(const _Value& data, bool pretty);
+
+		 void write_parallel(Arena* pool, const std::string& fileName, _Value& j, uint64_t thr_num, bool pretty);
+		 void write_parallel2(const std::string& fileName, const _Value& j, uint64_t thr_num, bool pretty);
+
+	};
+
+	claujson_inline void _write_string(StrStream& stream, char ch) {
+		switch (ch) {
+		case '\\':
+			stream.add_2("\\\\");
+			break;
+		case '\"':
+			stream.add_2("\\\"");
+			break;
+		case '\n':
+			stream.add_2("\\n");
+			break;
+		case '\b':
+			stream.add_2("\\b");
+			break;
+		case '\f':
+			stream.add_2("\\f");
+			break;
+		case '\r':
+			stream.add_2("\\r");
+			break;
+		case '\t':
+			stream.add_2("\\t");
+			break;
+		default:
+		{
+			int code = ch;
+			if ((code >= 0 && code < 0x20) || code == 0x7F)
 			{
 				char buf[] = "\\uDDDD";
 				snprintf(buf + 2, 5, "%04X", code);
@@ -3238,30 +4317,32 @@ namespace claujson {
 		return std::string(stream.buf(), stream.buf_size());
 	}
 
-	bool is_valid2(_simdjson::dom::parser_for_claujson& dom_parser, uint64_t start, uint64_t last,
+	bool is_valid2(const char* buf, _simdjson::internal::dom_parser_implementation* simdjson_imple, uint64_t start, uint64_t last,
 		int* _start_state, int* _last_state,
 		Vector<int8_t>* _is_array, Vector<int8_t>* _is_virtual_array,
-		uint64_t* count = nullptr
+		uint64_t* count, bool whole,
+		Vector<uint64_t>* _open, Vector<uint64_t>* _virtual_count,
+		uint64_t count_base
 		) {
-
-		const auto& buf = dom_parser.raw_buf();
-
-		auto* simdjson_imple = dom_parser.raw_implementation().get();
 		uint64_t idx = start;
+		const bool is_part = start > 0 && !whole;
+		const uint64_t last_token = whole ? last : simdjson_imple->n_structural_indexes - 1;
 		uint64_t depth = 0;
 
 		Vector<int8_t> is_array;
 		Vector<int8_t> is_virtual_array;
 		Vector<uint64_t> _stack;
+		Vector<uint64_t> virtual_count_list;
+		int64_t virtual_count = is_part ? -1 : 0; // number of items at depth 0, first ',' counts the last item of the previous part.
 
 		int state = 0;
-		uint64_t no = start;
+		uint64_t no = start - count_base;
 
 		if (start > last) {
 			return false;
 		}
 
-		if (start > 0 && start == last) {
+		if (is_part && start == last) {
 			return false; // 
 		}
 		//
@@ -3286,7 +4367,7 @@ namespace claujson {
 			// could get into memory corruption. See https://github.com/simdjson/simdjson/issues/906
 			//if (!STREAMING) {
 			switch (value) {
-			case '{': if (buf[simdjson_imple->structural_indexes[simdjson_imple->n_structural_indexes - 1]] != '}') {
+			case '{': if (buf[simdjson_imple->structural_indexes[last_token]] != '}') {
 				log << warn << ("starting brace unmatched");
 
 				//if (err) {
@@ -3296,7 +4377,7 @@ namespace claujson {
 				return false;
 			}
 					break;
-			case '[': if (buf[simdjson_imple->structural_indexes[simdjson_imple->n_structural_indexes - 1]] != ']') {
+			case '[': if (buf[simdjson_imple->structural_indexes[last_token]] != ']') {
 				log << warn << ("starting bracket unmatched");
 				//if (err) {
 				//	*err = 1;
@@ -3323,7 +4404,7 @@ namespace claujson {
 			}
 
 
-			if (start > 0 && value == ',') {
+			if (is_part && value == ',') {
 				if (idx < simdjson_imple->n_structural_indexes - 1) {
 					if (buf[simdjson_imple->structural_indexes[idx + 1]] == ':') {
 						--idx;
@@ -3448,12 +4529,9 @@ namespace claujson {
 		if (!_stack.empty()) {
 			count[_stack.back()]++;
 		}
-		//else {
-			//if (virtual_count == 0) {
-			//	virtual_idx = idx - 1;
-			//}
-			//virtual_count++;
-		//}
+		else {
+			virtual_count++;
+		}
 
 		{
 			if (idx > last) {
@@ -3498,12 +4576,14 @@ namespace claujson {
 				// depth <= 0.. virtual array or virtual object..
 				switch (buf[simdjson_imple->structural_indexes[idx - 1]]) {
 				case ']': 
-					is_virtual_array.push_back(1); //count[virtual_idx] = virtual_count; virtual_count = 0;
+					is_virtual_array.push_back(1);
 					break;
 				case '}':
-					is_virtual_array.push_back(0); //count[virtual_idx] = virtual_count;  virtual_count = 0;
+					is_virtual_array.push_back(0);
 					break;
 				}
+				virtual_count_list.push_back(virtual_count);
+				virtual_count = 0;
 			}
 
 			if (idx > last || (start == 0 && depth == 0)) {
@@ -3534,6 +4614,7 @@ namespace claujson {
 					case ']':
 					case '}':
 						++idx;
+						virtual_count++; // closed one is an item of the next virtual array or object.
 						goto scope_end;
 						break;
 					default:
@@ -3619,12 +4700,9 @@ namespace claujson {
 		if (!_stack.empty()) {
 			count[_stack.back()]++;
 		}
-		//else {
-			//if (virtual_count == 0) {
-			//	virtual_idx = idx - 1;
-			//}
-			//virtual_count++;
-		//}
+		else {
+			virtual_count++;
+		}
 
 		{
 			if (idx > last) {
@@ -3673,9 +4751,87 @@ namespace claujson {
 			*_is_virtual_array = std::move(is_virtual_array);
 		}
 
+		if (_open) {
+			*_open = std::move(_stack);
+		}
+
+		if (_virtual_count) {
+			virtual_count_list.push_back(virtual_count);
+			*_virtual_count = std::move(virtual_count_list);
+		}
+
 		return true;
 	}
 
+	// chk results of is_valid2 for divided tokens. (n : number of divided parts) 0 -> valid
+	int is_valid2_merge(const my_vector<int>& start_state, const my_vector<int>& last_state,
+		my_vector<Vector<int8_t>>& is_array, my_vector<Vector<int8_t>>& is_virtual_array, uint64_t n) {
+
+		for (uint64_t i = 0; i < n - 1; ++i) {
+			if (start_state[i + 1] != last_state[i]) { // need more tests.
+				return -2;
+			}
+		}
+
+		if (is_virtual_array[0].empty() == false) { // first block has no virtual array or virtual object.!
+			return -3;
+		}
+
+		for (uint64_t i = 1; i < n; ++i) {
+			if (is_array[0].empty()) {
+				return -5;
+			}
+
+			if (false == is_virtual_array[i].empty()) {
+				// remove? matched is_array(or object) and is_virtual_array(or object)
+				if (is_array[0].size() >= is_virtual_array[i].size()) {
+					for (uint64_t j = 0; j < is_virtual_array[i].size(); ++j) {
+						if (is_array[0].back() != is_virtual_array[i][j]) {
+							return -3;
+						}
+						is_array[0].pop_back();
+					}
+				}
+				else {
+					return -3;
+				}
+			}
+			// added...
+			for (uint64_t x = 0; x < is_array[i].size(); ++x) {
+				is_array[0].push_back(is_array[i][x]);
+			}
+
+			//is_array[0].insert(is_array[0].end(), is_array[i].begin(), is_array[i].end());
+		}
+
+		if (false == is_array[0].empty()) {
+			return -4;
+		}
+
+		return 0;
+	}
+
+	// count[container] <- number of items in all parts, after is_valid2_merge returns 0. (n : number of divided parts)
+	void is_valid2_count(my_vector<Vector<uint64_t>>& open, my_vector<Vector<uint64_t>>& virtual_count, uint64_t* count, uint64_t n) {
+		Vector<uint64_t> _stack; // containers not closed yet.
+
+		for (uint64_t i = 0; i < n; ++i) {
+			const uint64_t virtual_num = virtual_count[i].size() - 1;
+
+			for (uint64_t j = 0; j < virtual_num; ++j) { // virtual array or virtual object -> close _stack.back()
+				count[_stack.back()] += virtual_count[i][j];
+				_stack.pop_back();
+			}
+			if (!_stack.empty()) {
+				count[_stack.back()] += virtual_count[i][virtual_num];
+			}
+
+			for (uint64_t x = 0; x < open[i].size(); ++x) {
+				_stack.push_back(open[i][x]);
+			}
+		}
+	}
+
 	bool is_valid(_simdjson::dom::parser_for_claujson& dom_parser, uint64_t middle, my_vector<int>* _is_array = nullptr, int* err = nullptr) {
 
 		const auto& buf = dom_parser.raw_buf();
@@ -4351,12 +5507,140 @@ namespace claujson {
 	[[nodiscard]]
 	std::unique_ptr<ThreadPool> pool_init(int thr_num);
 
+	// estimated cost of tree building for a token, 1 ~ 10ns. (string, number -> + bytes)
+	inline uint64_t TokenCost(const char* buf, const uint32_t* tokens, uint64_t i) {
+		const uint64_t len = tokens[i + 1] - tokens[i];
+		switch (buf[tokens[i]]) {
+		case '"':
+			return 6 + len / 14;
+		case '{':
+		case '[':
+			return 9;
+		case '}':
+		case ']':
+			return 2;
+		case ',':
+		case ':':
+			return 1;
+		case 't':
+		case 'f':
+		case 'n':
+			return 3;
+		default: // number
+			return 4 + len / 8;
+		}
+	}
+
+	// number of parts for thr_num threads. a slow part does not stall the others. (at least 64K tokens per part)
+	inline uint64_t PartNum(uint64_t length, uint64_t thr_num) {
+		if (thr_num <= 1 || length < (1 << 12)) { // small -> one part, split costs more than parse.
+			return 1;
+		}
+		return std::max(thr_num, std::min(thr_num * 4, length >> 16));
+	}
+
+	// pivot[i] : token idx where cost of [0, pivot[i]) ~ total cost * i / thr_num. pivot[0] = 0, pivot[thr_num] = length
+	static my_vector<uint64_t> FindPivots(ThreadPool* pool, const char* buf, _simdjson::internal::dom_parser_implementation* imple,
+		uint64_t length, uint64_t thr_num)
+	{
+		my_vector<uint64_t> pivot(thr_num + 1);
+		pivot[0] = 0;
+		pivot[thr_num] = length;
+
+		const uint64_t slice_num = std::min<uint64_t>(thr_num * 64, length);
+
+		if (thr_num <= 1 || slice_num < thr_num) {
+			for (uint64_t i = 1; i < thr_num; ++i) {
+				pivot[i] = length / thr_num * i;
+			}
+			return pivot;
+		}
+
+		const uint32_t* tokens = imple->structural_indexes.get();
+
+		// slice i : [length / slice_num * i, length / slice_num * (i + 1)), last slice ends with length.
+		my_vector<uint64_t> slice_cost(slice_num);
+		{
+			my_vector<std::future<void>> result(thr_num);
+			for (uint64_t t = 0; t < thr_num; ++t) {
+				result[t] = pool->enqueue([=, &slice_cost]() {
+					for (uint64_t i = slice_num / thr_num * t; i < (t + 1 == thr_num ? slice_num : slice_num / thr_num * (t + 1)); ++i) {
+						const uint64_t last = i + 1 == slice_num ? length : length / slice_num * (i + 1);
+						uint64_t cost = 0;
+						for (uint64_t k = length / slice_num * i; k < last; ++k) {
+							cost += TokenCost(buf, tokens, k);
+						}
+						slice_cost[i] = cost;
+					}
+				});
+			}
+			for (auto& x : result) {
+				x.get();
+			}
+		}
+
+		uint64_t total = 0;
+		for (uint64_t i = 0; i < slice_num; ++i) {
+			total += slice_cost[i];
+		}
+
+		// last part has the end of root, so values of root in the last part are moved once more in __LoadData.
+		// (to virtual array or object) -> find last pivot from the end, with the extra cost.
+		uint64_t last_cost = 0; // cost of [k, length)
+		{
+			const uint64_t root_value_cost = 5;
+			uint64_t extra = 0;
+			uint64_t depth = 0;
+			uint64_t k = length;
+			while (k > 1 && (last_cost + extra) * thr_num < total + extra) {
+				--k;
+				const char ch = buf[tokens[k]];
+				if (ch == '}' || ch == ']') {
+					++depth;
+				}
+				else if (ch == '{' || ch == '[') {
+					--depth;
+				}
+				else if (ch == ',' && depth == 1) {
+					extra += root_value_cost;
+				}
+				last_cost += TokenCost(buf, tokens, k);
+			}
+			pivot[thr_num - 1] = k;
+		}
+
+		const uint64_t before_total = total - std::min(total, last_cost); // cost of [0, pivot[thr_num - 1])
+
+		uint64_t sum = 0; // cost of [0, slice i)
+		uint64_t i = 0;
+		for (uint64_t t = 1; t + 1 < thr_num; ++t) {
+			const uint64_t target = before_total / (thr_num - 1) * t;
+			while (i + 1 < slice_num && sum + slice_cost[i] <= target) {
+				sum += slice_cost[i];
+				++i;
+			}
+			// in slice i
+			uint64_t k = length / slice_num * i;
+			const uint64_t last = i + 1 == slice_num ? length : length / slice_num * (i + 1);
+			uint64_t now = sum;
+			while (k < last && now < target) {
+				now += TokenCost(buf, tokens, k);
+				++k;
+			}
+			pivot[t] = std::min(std::max(k, pivot[t - 1]), pivot[thr_num - 1]);
+		}
+
+		return pivot;
+	}
+
 	parser::parser(int thr_num) {
 		pool = pool_init(thr_num);
 	}
 
 	std::pair<bool, uint64_t> parser::parse(const std::string& fileName, Document& d, uint64_t thr_num)
 	{
+		auto _ = std::chrono::steady_clock::now();
+
 		if (thr_num <= 0) {
 			thr_num = std::max((int)std::thread::hardware_concurrency() - 2, 1);
 		}
@@ -4364,42 +5648,144 @@ namespace claujson {
 			thr_num = 1;
 		}
 
-		_Value& ut = d.Get(); 
-
-		uint64_t length = 0;
-
-		auto _ = std::chrono::steady_clock::now();
+		log << info << "simdjson-stage1 start\n";
 
-		uint64_t* count_vec = nullptr;
+		uint64_t file_len = 0;
 		{
+			std::ifstream inFile(fileName, std::ios::binary | std::ios::ate);
+			if (!inFile) {
+				log << warn << "file open error\n";
+				return { false, 0 };
+			}
+			file_len = static_cast<uint64_t>(inFile.tellg());
+		}
 
-			log << info << "simdjson-stage1 start\n";
-			// not static??
-			auto x = test_.load(fileName);
-
-			if (x.error() != _simdjson::error_code::SUCCESS) {
-				log << warn << "stage1 error : ";
-				log << warn << x.error() << "\n";
+		char* buf = nullptr;
+		std::shared_ptr<void> owner; // of buf, if d can keep it.
+		_simdjson::internal::dom_parser_implementation* simdjson_imple_ = nullptr;
 
-				//ERROR(_simdjson::error_message(x.error()));
+		if ((thr_num > 1 && (file_len >> 20) > 1) || d.IsLazy() || d.IsZeroCopy()) { // big file -> parallel stage1, lazy or zero copy -> d keeps buf_.
+			if (file_len > _simdjson::_SIMDJSON_MAXSIZE_BYTES) {
+				log << warn << "file is too big\n";
+				return { false, 0 };
+			}
 
+			buf = _get_buf(file_len);
+			if (!buf) {
+				log << warn << "memory alloc error\n";
 				return { false, 0 };
 			}
 
-			d.pool->Reset(); //
-			ut = _Value();
+			{
+				std::ifstream inFile(fileName, std::ios::binary);
+				if (!inFile || !inFile.read(buf, file_len)) {
+					log << warn << "file read error\n";
+					return { false, 0 };
+				}
+			}
 
-			const auto& buf = test_.raw_buf();
-			const auto buf_len = test_.raw_len();
+			auto err = _stage1(buf, file_len, thr_num);
 
-			auto* simdjson_imple_ = test_.raw_implementation().get();
+			if (err != _simdjson::error_code::SUCCESS) {
+				log << warn << "stage1 error : ";
+				log << warn << err << "\n";
+
+				return { false, 0 };
+			}
+
+			simdjson_imple_ = imple_.get();
+			owner = buf_;
+		}
+		else {
+			// not static??
+			auto x = test_.load(fileName);
+
+			if (x.error() != _simdjson::error_code::SUCCESS) {
+				log << warn << "stage1 error : ";
+				log << warn << x.error() << "\n";
+
+				//ERROR(_simdjson::error_message(x.error()));
+
+				return { false, 0 };
+			}
+
+			buf = test_.raw_buf();
+			file_len = test_.raw_len();
+			simdjson_imple_ = test_.raw_implementation().get();
+		}
+
+		auto a = std::chrono::steady_clock::now();
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(a - _);
+		log << info << dur.count() << "ms\n";
+
+		auto result = _parse(d, buf, file_len, simdjson_imple_, thr_num, false, std::move(owner));
+
+		dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _);
+		log << info << dur.count() << "ms\n";
+
+		return result;
+	}
+
+	// call after Reset of the Arena of d, (values of old input are gone) no owner -> copy of input in Arena of d. (not shard)
+	char* parser::_keep_input(Document& d, char* buf, uint64_t buf_len, std::shared_ptr<void> owner) {
+		Arena* pool = d.pool;
+		d.input = nullptr;
+		if (!d.IsLazy() && !d.IsZeroCopy()) {
+			return buf;
+		}
+		char* input = buf;
+		if (owner) {
+			d.input = std::move(owner);
+		}
+		else {
+			input = pool->allocate<char>(buf_len + _simdjson::_SIMDJSON_PADDING);
+			if (!input) {
+				log << warn << "memory alloc error, input is not kept\n";
+				return buf;
+			}
+			memcpy(input, buf, buf_len);
+			memset(input + buf_len, ' ', _simdjson::_SIMDJSON_PADDING);
+		}
+		pool->SetInput(input, buf_len + _simdjson::_SIMDJSON_PADDING);
+		pool->EnableLazy(d.IsLazy());
+		pool->EnableZeroCopy(d.IsZeroCopy());
+		return input;
+	}
+
+	// flags of _keep_input are for parsing only.
+	struct KeepInputOff {
+		Arena* pool;
+		~KeepInputOff() {
+			pool->EnableLazy(false);
+			pool->EnableZeroCopy(false);
+		}
+	};
+
+	// after stage1, buf must be padded. (_SIMDJSON_PADDING)
+	std::pair<bool, uint64_t> parser::_parse(Document& d, char* buf, uint64_t buf_len,
+		_simdjson::internal::dom_parser_implementation* simdjson_imple_, uint64_t thr_num, bool fused, std::shared_ptr<void> owner)
+	{
+		if (thr_num <= 0) {
+			thr_num = std::max((int)std::thread::hardware_concurrency() - 2, 1);
+		}
+		if (thr_num <= 0) {
+			thr_num = 1;
+		}
+
+		_Value& ut = d.Get(); 
+
+		uint64_t length = 0;
+
+		uint64_t* count_vec = nullptr;
+		{
+			d.pool->Reset(); //
+			ut = _Value();
 
 			my_vector<int64_t> start(thr_num + 1);
 			//my_vector<int> key;
 
 			auto a = std::chrono::steady_clock::now();
-			auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(a - _);
-			log << info << dur.count() << "ms\n";
+			std::chrono::milliseconds dur;
 
 
 			{
@@ -4423,7 +5809,8 @@ namespace claujson {
 
 			b = std::chrono::steady_clock::now();
 
-				std::set<uint64_t> _set;
+			uint64_t part_count = 1; // one part -> start = { 0, length }, no pivots and tasks.
+			my_vector<uint64_t> item_num;
 			//if (!is_valid(test, length - 1)) {
 			//	return { false, 0 };
 			//}
@@ -4436,18 +5823,32 @@ namespace claujson {
 				{
 
 				//	my_vector<uint64_t> start(thr_num + 1);
-					my_vector<uint64_t> last(thr_num);
+					const uint64_t part_num = PartNum(length, thr_num); // parts > threads, threads take parts from the queue.
+
+					if (!fused) {
+						count_vec = _get_count_vec(length);
+						if (!count_vec) {
+							log << "malloc fail in parse function.";
+							return { false, -55 };
+						}
+					}
+
+					if (part_num > 1) {
+					std::set<uint64_t> _set;
+					my_vector<uint64_t> last(part_num);
 
-					my_vector<int> start_state(thr_num);
+					my_vector<int> start_state(part_num);
 					for (auto& x : start_state) {
 						x = -1;
 					}
-					my_vector<int> last_state(thr_num);
+					my_vector<int> last_state(part_num);
 					for (auto& x : last_state) {
 						x = -1;
 					}
-					for (uint64_t t = 1; t < thr_num; ++t) {
-						uint64_t middle = length / thr_num * t;
+					const my_vector<uint64_t> pivot = FindPivots(pool.get(), buf, simdjson_imple_, length, part_num);
+
+					for (uint64_t t = 1; t < part_num; ++t) {
+						uint64_t middle = pivot[t];
 						for (uint64_t i = middle; i < length; ++i) {
 							if (buf[simdjson_imple_->structural_indexes[i]] == ',') {
 								_set.insert(i); break;
@@ -4456,6 +5857,7 @@ namespace claujson {
 					}
 
 					_set.insert(0);
+					part_count = _set.size();
 
 					start.resize(1 + _set.size());
 					last.resize(_set.size());
@@ -4467,123 +5869,866 @@ namespace claujson {
 					}
 					start[_set.size()] = length - 1;
 
-					for (uint64_t i = 0; i < _set.size(); ++i) {
-						last[i] = start[i + 1];
-					}
+					for (uint64_t i = 0; i < _set.size(); ++i) {
+						last[i] = start[i + 1];
+					}
+
+					my_vector<Vector<int8_t>> is_array(_set.size()), is_virtual_array(_set.size());
+					my_vector<Vector<uint64_t>> open(_set.size()), virtual_count(_set.size());
+					my_vector<std::future<bool>> thr_result(_set.size());
+					//int err = 0;
+
+					if (fused) {
+						// __LoadData checks grammar. (count_vec == nullptr)
+					}
+					else {
+
+						for (uint64_t i = 0; i < _set.size(); ++i) {
+							thr_result[i] = pool->enqueue(is_valid2, buf, simdjson_imple_, start[i], last[i], &start_state[i], &last_state[i],
+								&is_array[i], &is_virtual_array[i], count_vec, false, &open[i], &virtual_count[i], 0);
+						}
+						my_vector<int> result(_set.size());
+
+						for (uint64_t i = 0; i < _set.size(); ++i) {
+							result[i] = static_cast<int>(thr_result[i].get());
+						}
+
+						for (uint64_t i = 0; i < result.size(); ++i) {
+							if (result[i] == false) {
+								return { false, -1 };
+							}
+						}
+
+						{
+							int err = is_valid2_merge(start_state, last_state, is_array, is_virtual_array, _set.size());
+							if (err != 0) {
+								return { false, err };
+							}
+						}
+
+						// items in next parts -> exact reserve for containers in many parts.
+						is_valid2_count(open, virtual_count, count_vec, _set.size());
+
+						// virtual_count starts from -1 at ',' of part start, last item of the part is counted by the next part.
+						item_num = my_vector<uint64_t>(_set.size());
+						for (uint64_t i = 0; i < _set.size(); ++i) {
+							item_num[i] = 1;
+							for (uint64_t j = 0; j < virtual_count[i].size(); ++j) {
+								item_num[i] = std::max<uint64_t>(item_num[i], (int64_t)virtual_count[i][j] + 1);
+							}
+						}
+					}
+					}
+					else if (!fused) {
+						int start_state = 0;
+						int last_state = 0;
+
+						if (!is_valid2(buf, simdjson_imple_, 0, length - 1, &start_state, &last_state,
+							nullptr, nullptr, count_vec, true)) {
+							return { false, -1 };
+						}
+					}
+				}
+
+				dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - a);
+				log << info << "test time " << dur.count() << "ms\n";
+			}
+			dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - b);
+			log << info << dur.count() << "ms\n";
+
+			b = std::chrono::steady_clock::now();
+
+			start[part_count] = length;
+			thr_num = part_count;
+
+			KeepInputOff keep_off{ d.pool };
+			char* input = _keep_input(d, buf, buf_len, std::move(owner));
+
+			LoadData2 p(pool.get());
+			p.item_num = std::move(item_num);
+						
+			bool parse_ok = p.parse(ut, d.pool, input, buf_len, simdjson_imple_, length, start, count_vec,
+				thr_num); // 0 : use all thread..
+			imbalance_ = p.imbalance;
+			if (false == parse_ok)
+			{
+				return { false, 0 };
+			}
+			auto c = std::chrono::steady_clock::now();
+			dur = std::chrono::duration_cast<std::chrono::milliseconds>(c - b);
+
+			log << info << dur.count() << "ms\n";
+		}
+
+		return  { true, length };
+	}
+
+#ifndef _WIN32
+	// private (copy on write) file mapping + zero filled padding. (_SIMDJSON_PADDING) zero copy writes '\0' at end of strings.
+	class MappedFile {
+	private:
+		char* ptr = nullptr;
+		uint64_t map_len = 0;
+		uint64_t len = 0;
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile() {
+			if (ptr) {
+				munmap(ptr, map_len);
+			}
+		}
+	public:
+		bool open(const std::string& fileName) {
+			int fd = ::open(fileName.c_str(), O_RDONLY);
+			if (fd < 0) {
+				return false;
+			}
+
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+				::close(fd);
+				return false;
+			}
+
+			len = static_cast<uint64_t>(st.st_size);
+
+			const uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+			map_len = (len + _simdjson::_SIMDJSON_PADDING + page_size - 1) / page_size * page_size;
+
+			// reserve len + padding with anonymous (zero) pages, then map file over it.
+			// -> bytes after end of file are always readable and zero, no SIGBUS.
+			void* base = mmap(nullptr, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (base == MAP_FAILED) {
+				::close(fd);
+				return false;
+			}
+			ptr = static_cast<char*>(base);
+
+			void* file = mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+			::close(fd);
+
+			if (file == MAP_FAILED) {
+				return false;
+			}
+
+			madvise(base, len, MADV_WILLNEED);
+
+			return true;
+		}
+
+		char* data() const { return ptr; }
+		uint64_t size() const { return len; }
+	};
+#endif
+
+	// create or grow.
+	static bool allocate_imple(std::unique_ptr<_simdjson::internal::dom_parser_implementation>& imple, uint64_t capacity) {
+		if (imple && imple->capacity() >= capacity) {
+			return true;
+		}
+		if (imple) {
+			return imple->allocate(capacity, _simdjson::DEFAULT_MAX_DEPTH) == _simdjson::error_code::SUCCESS;
+		}
+		return _simdjson::get_active_implementation()->create_dom_parser_implementation(capacity,
+			_simdjson::DEFAULT_MAX_DEPTH, imple) == _simdjson::error_code::SUCCESS;
+	}
+
+	uint64_t* parser::_get_count_vec(uint64_t len) {
+		if (count_vec_capacity_ < len) {
+			count_vec_.reset(new (std::nothrow) uint64_t[len]);
+			count_vec_capacity_ = count_vec_ ? len : 0;
+		}
+		return count_vec_.get();
+	}
+
+	char* parser::_get_buf(uint64_t buf_len) {
+		if (buf_capacity_ < buf_len + _simdjson::_SIMDJSON_PADDING || buf_.use_count() > 1) { // small, or kept by Document.
+			buf_.reset(new (std::nothrow) char[buf_len + _simdjson::_SIMDJSON_PADDING], std::default_delete<char[]>());
+			buf_capacity_ = buf_ ? buf_len + _simdjson::_SIMDJSON_PADDING : 0;
+		}
+		if (buf_) {
+			std::memset(buf_.get() + buf_len, 0, _simdjson::_SIMDJSON_PADDING);
+		}
+		return buf_.get();
+	}
+
+	// byte ranges end with ',', and are scanned at the same time. (assume that range does not start in string.)
+	// then chk ranges in order, if a range ends in string, next part is scanned again. (stage1_chunk)
+	_simdjson::error_code parser::_stage1(const char* buf, uint64_t buf_len, uint64_t thr_num)
+	{
+		if (!allocate_imple(imple_, buf_len)) {
+			return _simdjson::error_code::MEMALLOC;
+		}
+
+		// at least 1MB per range.
+		const uint64_t range_num_max = std::min<uint64_t>(thr_num, buf_len >> 20);
+
+		if (range_num_max <= 1) {
+			return imple_->stage1(reinterpret_cast<const uint8_t*>(buf), buf_len, _simdjson::stage1_mode::regular);
+		}
+
+		std::vector<uint64_t> range;
+		range.push_back(0);
+		for (uint64_t i = 1; i < range_num_max; ++i) {
+			uint64_t x = FindChunkEnd(buf, buf_len, buf_len / range_num_max * i);
+			if (x > range.back() && x < buf_len) {
+				range.push_back(x);
+			}
+		}
+		range.push_back(buf_len);
+
+		const uint64_t range_num = range.size() - 1;
+
+		if (range_imples_.size() < range_num) {
+			range_imples_.resize(range_num);
+		}
+
+		std::vector<std::future<_simdjson::error_code>> result(range_num);
+
+		for (uint64_t i = 0; i < range_num; ++i) {
+			if (!allocate_imple(range_imples_[i], range[i + 1] - range[i])) {
+				for (uint64_t j = 0; j < i; ++j) {
+					result[j].get();
+				}
+				return _simdjson::error_code::MEMALLOC;
+			}
+			auto* imple = range_imples_[i].get();
+			const uint8_t* range_buf = reinterpret_cast<const uint8_t*>(buf) + range[i];
+			const uint64_t range_len = range[i + 1] - range[i];
+			result[i] = pool->enqueue([imple, range_buf, range_len]() {
+				return imple->stage1(range_buf, range_len, _simdjson::stage1_mode::regular);
+			});
+		}
+
+		std::vector<_simdjson::error_code> err(range_num);
+		for (uint64_t i = 0; i < range_num; ++i) {
+			err[i] = result[i].get();
+		}
+
+		struct Part {
+			const uint32_t* tokens;
+			uint64_t n;
+			uint64_t offset; // add to tokens
+			uint64_t to; // idx in imple_->structural_indexes
+		};
+
+		std::vector<Part> part;
+		std::list<std::vector<uint32_t>> fixed; // scanned again
+
+		uint64_t pos = 0; // pos is not in string.
+		uint64_t k = 0;
+		uint64_t n = 0;
+
+		while (pos < buf_len) {
+			while (range[k] < pos) {
+				++k;
+			}
+
+			if (range[k] == pos && (err[k] != _simdjson::error_code::UNCLOSED_STRING || range[k + 1] == buf_len)) {
+				if (err[k] != _simdjson::error_code::SUCCESS && err[k] != _simdjson::error_code::EMPTY) {
+					return err[k];
+				}
+
+				const uint64_t range_n = err[k] == _simdjson::error_code::SUCCESS ? range_imples_[k]->n_structural_indexes : 0;
+				const uint32_t* tokens = range_imples_[k]->structural_indexes.get();
+
+				if (range[k + 1] < buf_len && (range_n == 0 || tokens[range_n - 1] + range[k] != range[k + 1] - 1)) { // chk
+					return _simdjson::error_code::UNEXPECTED_ERROR;
+				}
+
+				part.push_back({ tokens, range_n, range[k], n });
+				n += range_n;
+				pos = range[k + 1];
+				continue;
+			}
+
+			// pos ~ next range (or more)
+			uint64_t end = range[k] == pos ? range[k + 1] : range[k];
+
+			if (!allocate_imple(chunk_imple_, end - pos)) {
+				return _simdjson::error_code::MEMALLOC;
+			}
+
+			auto e = stage1_chunk(chunk_imple_.get(), buf, buf_len, pos, &end);
+
+			if (e != _simdjson::error_code::SUCCESS && e != _simdjson::error_code::EMPTY) {
+				return e;
+			}
+
+			const uint64_t chunk_n = e == _simdjson::error_code::SUCCESS ? chunk_imple_->n_structural_indexes : 0;
+			const uint32_t* tokens = chunk_imple_->structural_indexes.get();
+
+			if (end < buf_len && (chunk_n == 0 || tokens[chunk_n - 1] + pos != end - 1)) { // chk
+				return _simdjson::error_code::UNEXPECTED_ERROR;
+			}
+
+			fixed.emplace_back(tokens, tokens + chunk_n);
+			part.push_back({ fixed.back().data(), chunk_n, pos, n });
+			n += chunk_n;
+			pos = end;
+		}
+
+		if (n == 0) {
+			return _simdjson::error_code::EMPTY;
+		}
+
+		// concat.
+		uint32_t* tokens = imple_->structural_indexes.get();
+		std::vector<std::future<void>> copy_result(part.size());
+
+		for (uint64_t i = 0; i < part.size(); ++i) {
+			const Part x = part[i];
+			copy_result[i] = pool->enqueue([tokens, x]() {
+				const uint32_t offset = static_cast<uint32_t>(x.offset);
+				for (uint64_t j = 0; j < x.n; ++j) {
+					tokens[x.to + j] = x.tokens[j] + offset;
+				}
+			});
+		}
+		for (auto& x : copy_result) {
+			x.get();
+		}
+
+		tokens[n] = static_cast<uint32_t>(buf_len);
+		tokens[n + 1] = static_cast<uint32_t>(buf_len);
+		tokens[n + 2] = 0;
+		imple_->n_structural_indexes = static_cast<uint32_t>(n);
+		imple_->next_structural_index = 0;
+
+		return _simdjson::error_code::SUCCESS;
+	}
+
+	std::pair<bool, uint64_t> parser::parse_mmap(const std::string& fileName, Document& d, uint64_t thr_num)
+	{
+#ifdef _WIN32
+		return parse(fileName, d, thr_num);
+#else
+		auto _ = std::chrono::steady_clock::now();
+
+		auto mapped = std::make_shared<MappedFile>(); // lazy or zero copy -> kept by d.
+		MappedFile& file = *mapped;
+
+		if (!file.open(fileName)) {
+			log << warn << "mmap fail : " << fileName << "\n";
+			return { false, 0 };
+		}
+
+		if (file.size() > _simdjson::_SIMDJSON_MAXSIZE_BYTES) {
+			log << warn << "file is too big\n";
+			return { false, 0 };
+		}
+
+		log << info << "simdjson-stage1 start (mmap)\n";
+
+		if (!allocate_imple(imple_, file.size())) {
+			log << warn << "stage1 allocate fail\n";
+			return { false, 0 };
+		}
+
+		auto err = imple_->stage1(reinterpret_cast<const uint8_t*>(file.data()), file.size(), _simdjson::stage1_mode::regular);
+
+		if (err != _simdjson::error_code::SUCCESS) {
+			log << warn << "stage1 error : ";
+			log << warn << err << "\n";
+
+			return { false, 0 };
+		}
+
+		auto a = std::chrono::steady_clock::now();
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(a - _);
+		log << info << dur.count() << "ms\n";
+
+		auto result = _parse(d, file.data(), file.size(), imple_.get(), thr_num, false, mapped);
+
+		dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _);
+		log << info << dur.count() << "ms\n";
+
+		return result; // strings are copied to d.pool, (or d keeps the mapping) so unmap here is ok.
+#endif
+	}
+
+	std::pair<bool, uint64_t> parser::parse_pipelined(const std::string& fileName, Document& d, uint64_t thr_num)
+	{
+#ifdef _WIN32
+		return parse(fileName, d, thr_num);
+#else
+		if (thr_num <= 0) {
+			thr_num = std::max((int)std::thread::hardware_concurrency() - 2, 1);
+		}
+		if (thr_num <= 0) {
+			thr_num = 1;
+		}
+
+		auto _ = std::chrono::steady_clock::now();
+
+		MappedFile file;
+
+		if (!file.open(fileName)) {
+			log << warn << "mmap fail : " << fileName << "\n";
+			return { false, 0 };
+		}
+
+		if (file.size() >= _simdjson::_SIMDJSON_MAXSIZE_BYTES) {
+			log << warn << "file is too big\n";
+			return { false, 0 };
+		}
+
+		// 4 chunks per thread, at least 1MB.
+		const uint64_t chunk_size = std::max<uint64_t>(file.size() / (thr_num * 4), 1 << 20);
+
+		if (!allocate_imple(imple_, file.size()) || !allocate_imple(chunk_imple_, std::min<uint64_t>(chunk_size * 2, file.size()))) {
+			log << warn << "stage1 allocate fail\n";
+			return { false, 0 };
+		}
+
+		d.pool->Reset(); //
+		d.Get() = _Value();
+
+		int64_t length = 0;
+
+		LoadData2 p(pool.get());
+
+		bool ok = p.parse_pipelined(d.Get(), d.pool, file.data(), file.size(), imple_.get(), chunk_imple_.get(), chunk_size, length);
+
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _);
+		log << info << dur.count() << "ms\n";
+
+		return { ok, ok ? length : 0 };
+#endif
+	}
+
+
+	// first line (from 1) with a string not closed in the line, 0 if none. (error message of parse_ndjson)
+	static uint64_t FindUnclosedLine(const char* buf, uint64_t buf_len) {
+		uint64_t line = 1;
+		uint64_t pos = 0;
+		while (pos < buf_len) {
+			const char* x = (const char*)memchr(buf + pos, '\n', buf_len - pos);
+			const uint64_t line_end = x ? x - buf : buf_len;
+			uint64_t idx = pos;
+			while (true) {
+				const uint64_t quote = NextQuote(buf, line_end, pos, idx);
+				if (quote >= line_end) {
+					break;
+				}
+				const uint64_t end_quote = NextQuote(buf, line_end, pos, quote + 1);
+				if (end_quote >= line_end) {
+					return line;
+				}
+				idx = end_quote + 1;
+			}
+			pos = line_end + 1;
+			++line;
+		}
+		return 0;
+	}
+
+	// first tokens of top-level values -> line_start, and length. values must be separated by newline.
+	static bool FindLines(const char* buf, _simdjson::internal::dom_parser_implementation* imple, my_vector<int64_t>& line_start)
+	{
+		const uint64_t n = imple->n_structural_indexes;
+		const uint32_t* tokens = imple->structural_indexes.get();
+		uint64_t depth = 0;
+
+		for (uint64_t i = 0; i < n; ++i) {
+			const char ch = buf[tokens[i]];
+
+			if (depth == 0) {
+				if (ch == ',' || ch == ':' || ch == '}' || ch == ']') {
+					return false;
+				}
+				if (i > 0) { // chk newline between values.
+					uint64_t j = tokens[i];
+					bool newline = false;
+					while (j > 0) {
+						const char x = buf[j - 1];
+						if (x == '\n') {
+							newline = true;
+						}
+						else if (x != ' ' && x != '\t' && x != '\r') {
+							break;
+						}
+						--j;
+					}
+					if (!newline) {
+						return false;
+					}
+				}
+				line_start.push_back(i);
+			}
+
+			if (ch == '{' || ch == '[') {
+				++depth;
+			}
+			else if (ch == '}' || ch == ']') {
+				--depth;
+			}
+		}
+
+		line_start.push_back(n);
+
+		return true;
+	}
+
+	// buf[0, end) ends in string -> start of the string ('"')
+	static uint64_t FindStringStart(const char* buf, uint64_t end)
+	{
+		for (uint64_t i = end; i > 0; --i) {
+			if (buf[i - 1] == '"') {
+				uint64_t backslash = 0;
+				while (i - 1 > backslash && buf[i - 2 - backslash] == '\\') {
+					++backslash;
+				}
+				if (backslash % 2 == 0) {
+					return i - 1;
+				}
+			}
+		}
+		return 0;
+	}
+
+	static bool IsWhitespace(const char* buf, uint64_t len) {
+		for (uint64_t i = 0; i < len; ++i) {
+			if (buf[i] != ' ' && buf[i] != '\t' && buf[i] != '\r' && buf[i] != '\n') {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// window : [values of root (after ',')][not complete value] -> values are loaded, [not complete value] moves to front.
+	std::pair<bool, uint64_t> parser::parse_stream(const std::string& fileName, const std::function<bool(_Value& key, _Value& value)>& callback,
+		uint64_t window_size, uint64_t thr_num)
+	{
+		if (thr_num <= 0) {
+			thr_num = std::max((int)std::thread::hardware_concurrency() - 2, 1);
+		}
+		if (thr_num <= 0) {
+			thr_num = 1;
+		}
+		if (window_size < (1 << 16)) {
+			window_size = 1 << 16;
+		}
+
+		auto _ = std::chrono::steady_clock::now();
+
+		std::ifstream inFile(fileName, std::ios::binary);
+		if (!inFile) {
+			log << warn << "file open error\n";
+			return { false, 0 };
+		}
+
+		uint64_t capacity = window_size;
+		std::unique_ptr<char[]> window(new (std::nothrow) char[capacity + _simdjson::_SIMDJSON_PADDING]);
+		uint64_t filled = 0;
+		bool eof = false;
+
+		bool root_start = false; // found '[' or '{' of root?
+		bool is_object = false;
+		bool has_comma = false; // ',' of root.
+		uint64_t value_count = 0;
+
+		uint64_t* count_vec = nullptr;
+		uint64_t count_vec_capacity = 0;
+
+		Arena stream_pool; // blocks are reused, window by window.
+		LoadData2 p(pool.get());
+
+		bool ok = true;
+
+		while (ok) {
+			if (!window) {
+				log << warn << "memory alloc error\n";
+				ok = false;
+				break;
+			}
+
+			if (!eof && filled < capacity) {
+				inFile.read(window.get() + filled, capacity - filled);
+				filled += inFile.gcount();
+				eof = filled < capacity;
+			}
+
+			uint64_t end = filled;
+			if (!eof) { // do not divide utf-8 char.
+				while (end > 0 && (uint8_t)window[end - 1] >= 0x80) {
+					--end;
+				}
+			}
+
+			if (!allocate_imple(chunk_imple_, end)) {
+				log << warn << "stage1 allocate fail\n";
+				ok = false;
+				break;
+			}
+
+			auto err = end > 0 ? chunk_imple_->stage1((const uint8_t*)window.get(), end, _simdjson::stage1_mode::regular) : _simdjson::error_code::EMPTY;
+
+			if (err == _simdjson::error_code::UNCLOSED_STRING && !eof) { // end is in string.
+				end = FindStringStart(window.get(), end);
+				err = end > 0 ? chunk_imple_->stage1((const uint8_t*)window.get(), end, _simdjson::stage1_mode::regular) : _simdjson::error_code::EMPTY;
+			}
+
+			if (err != _simdjson::error_code::SUCCESS && err != _simdjson::error_code::EMPTY) {
+				log << warn << "stage1 error : ";
+				log << warn << err << "\n";
+				ok = false;
+				break;
+			}
+
+			const uint64_t n = err == _simdjson::error_code::SUCCESS ? chunk_imple_->n_structural_indexes : 0;
+			const uint32_t* tokens = chunk_imple_->structural_indexes.get();
+			const char* buf = window.get();
+
+			my_vector<int64_t> value_start;
+			my_vector<int64_t> value_end;
+
+			uint64_t i = 0;
+			uint64_t depth = 1;
+			int64_t last_comma = -1;
+			int64_t root_end = -1;
+
+			bool in_root = root_start;
+
+			if (!root_start && n > 0) { // window starts with '[' or '{' of root.
+				if (buf[tokens[0]] != '[' && buf[tokens[0]] != '{') {
+					log << warn << "root is not array or object\n";
+					ok = false;
+					break;
+				}
+				in_root = true;
+				is_object = buf[tokens[0]] == '{';
+				i = 1;
+			}
+
+			if (in_root) {
+				uint64_t now = i; // start of now value.
+
+				for (; i < n; ++i) {
+					const char ch = buf[tokens[i]];
+
+					if (ch == '{' || ch == '[') {
+						++depth;
+					}
+					else if (ch == '}' || ch == ']') {
+						--depth;
+						if (depth == 0) { // end of root
+							if (ch != (is_object ? '}' : ']') || i + 1 != n) {
+								ok = false;
+							}
+							else if (now < i) {
+								value_start.push_back(now);
+								value_end.push_back(i);
+							}
+							else if (has_comma) { // [ 1, ]
+								ok = false;
+							}
+							root_end = i;
+							break;
+						}
+					}
+					else if (ch == ',' && depth == 1) {
+						if (now == i) { // [ , ] or [ 1, , 2 ]
+							ok = false;
+							break;
+						}
+						value_start.push_back(now);
+						value_end.push_back(i);
+						has_comma = true;
+						last_comma = i;
+						now = i + 1;
+					}
+				}
+
+				if (!ok) {
+					log << warn << "not valid root\n";
+					break;
+				}
+			}
+
+			if (!in_root) { // only whitespace.
+				if (eof || !IsWhitespace(buf, filled)) {
+					log << warn << "not valid root\n";
+					ok = false;
+					break;
+				}
+				filled = 0;
+				continue;
+			}
 
-					my_vector<Vector<int8_t>> is_array(_set.size()), is_virtual_array(_set.size());
-					my_vector<std::future<bool>> thr_result(_set.size());
-					//int err = 0;
+			if (root_end < 0) {
+				if (eof) {
+					log << warn << "root is not closed\n";
+					ok = false;
+					break;
+				}
+				if (last_comma < 0) { // no complete value -> bigger window.
+					if (filled == capacity) {
+						std::unique_ptr<char[]> temp(new (std::nothrow) char[capacity * 2 + _simdjson::_SIMDJSON_PADDING]);
+						if (temp) {
+							std::memcpy(temp.get(), window.get(), filled);
+							capacity = capacity * 2;
+						}
+						window = std::move(temp);
+					}
+					continue;
+				}
+			}
 
-					count_vec = (uint64_t*)malloc(length * sizeof(uint64_t));
+			if (!value_start.empty()) {
+				if (count_vec_capacity < n) {
+					free(count_vec);
+					count_vec = (uint64_t*)malloc(sizeof(uint64_t) * n);
+					count_vec_capacity = count_vec ? n : 0;
 					if (!count_vec) {
-						log << "malloc fail in parse function.";
-						return { false, -55 };
+						log << warn << "malloc fail in parse_stream function.";
+						ok = false;
+						break;
 					}
+				}
 
-					if (thr_num > 1) {
+				stream_pool.Reset();
 
-						for (uint64_t i = 0; i < _set.size(); ++i) {
-							thr_result[i] = pool->enqueue(is_valid2, std::ref(test_), start[i], last[i], &start_state[i], &last_state[i],
-								&is_array[i], &is_virtual_array[i], count_vec);
-						}
-						my_vector<int> result(_set.size());
+				bool stop = false;
 
-						for (uint64_t i = 0; i < _set.size(); ++i) {
-							result[i] = static_cast<int>(thr_result[i].get());
-						}
+				if (!p.parse_values(&stream_pool, window.get(), end, chunk_imple_.get(), value_start, value_end, is_object,
+					count_vec, thr_num, callback, value_count, stop)) {
+					ok = false;
+					break;
+				}
 
-						for (uint64_t i = 0; i < result.size(); ++i) {
-							if (result[i] == false) {
-								free(count_vec);
-								return { false, -1 };
-							}
-						}
+				if (stop) {
+					break;
+				}
+			}
 
-						for (uint64_t i = 0; i < _set.size() - 1; ++i) {
-							if (start_state[i + 1] != last_state[i]) { // need more tests.
-								free(count_vec); return { false, -2 };
-							}
-						}
+			if (root_end >= 0) { // rest must be whitespace.
+				uint64_t from = tokens[root_end] + 1;
+				if (!IsWhitespace(buf + from, filled - from)) {
+					log << warn << "not valid root\n";
+					ok = false;
+					break;
+				}
+				while (!eof) {
+					inFile.read(window.get(), capacity);
+					filled = inFile.gcount();
+					eof = filled < capacity;
+					if (!IsWhitespace(window.get(), filled)) {
+						log << warn << "not valid root\n";
+						ok = false;
+						break;
+					}
+				}
+				break;
+			}
 
-						if (is_virtual_array[0].empty() == false) { // first block has no virtual array or virtual object.!
-							free(count_vec); return { false, -3 };
-						}
+			{
+				root_start = true;
+				uint64_t from = tokens[last_comma] + 1;
+				std::memmove(window.get(), window.get() + from, filled - from);
+				filled = filled - from;
+			}
+		}
 
-						for (uint64_t i = 1; i < _set.size(); ++i) {
-							if (is_array[0].empty()) {
-								free(count_vec);
-								return { false, -5 };
-							}
+		free(count_vec);
 
-							if (false == is_virtual_array[i].empty()) {
-								// remove? matched is_array(or object) and is_virtual_array(or object)
-								if (is_array[0].size() >= is_virtual_array[i].size()) {
-									for (uint64_t j = 0; j < is_virtual_array[i].size(); ++j) {
-										if (is_array[0].back() != is_virtual_array[i][j]) {
-											free(count_vec); return { false, -3 };
-										}
-										is_array[0].pop_back();
-									}
-								}
-								else {
-									free(count_vec); return { false, -3 };
-								}
-							}
-							// added...
-							for (uint64_t x = 0; x < is_array[i].size(); ++x) {
-								is_array[0].push_back(is_array[i][x]);
-							}
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _);
+		log << info << dur.count() << "ms\n";
 
-							//is_array[0].insert(is_array[0].end(), is_array[i].begin(), is_array[i].end());
-						}
+		return { ok, ok ? value_count : 0 };
+	}
 
-						if (false == is_array[0].empty()) {
-							free(count_vec); return { false, -4 };
-						}
-					}
-					else {
-						int start_state = 0;
-						int last_state = 0;
+	std::pair<bool, uint64_t> parser::parse_ndjson(const std::string& fileName, Document& d, uint64_t thr_num)
+	{
+		if (thr_num <= 0) {
+			thr_num = std::max((int)std::thread::hardware_concurrency() - 2, 1);
+		}
+		if (thr_num <= 0) {
+			thr_num = 1;
+		}
 
-						if (!is_valid2(test_, 0, length - 1, &start_state, &last_state,
-							nullptr, nullptr, count_vec)) {
-							free(count_vec);
-							return { false, 0 };
-						}
-					}
-				}
+		auto _ = std::chrono::steady_clock::now();
 
-				dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - a);
-				log << info << "test time " << dur.count() << "ms\n";
+		uint64_t file_len = 0;
+		{
+			std::ifstream inFile(fileName, std::ios::binary | std::ios::ate);
+			if (!inFile) {
+				log << warn << "file open error\n";
+				return { false, 0 };
 			}
-			dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - b);
-			log << info << dur.count() << "ms\n";
+			file_len = static_cast<uint64_t>(inFile.tellg());
+		}
 
-			b = std::chrono::steady_clock::now();
+		if (file_len > _simdjson::_SIMDJSON_MAXSIZE_BYTES) {
+			log << warn << "file is too big\n";
+			return { false, 0 };
+		}
 
-			start[_set.size()] = length;
-			thr_num = _set.size();
+		char* buf = _get_buf(file_len);
+		if (!buf) {
+			log << warn << "memory alloc error\n";
+			return { false, 0 };
+		}
 
-			LoadData2 p(pool.get());
-						
-			if (false == p.parse(ut, d.pool, buf, buf_len, simdjson_imple_, length, start, count_vec,
-				thr_num)) // 0 : use all thread..
-			{
-				free(count_vec);
+		{
+			std::ifstream inFile(fileName, std::ios::binary);
+			if (!inFile || !inFile.read(buf, file_len)) {
+				log << warn << "file read error\n";
 				return { false, 0 };
 			}
-			auto c = std::chrono::steady_clock::now();
-			dur = std::chrono::duration_cast<std::chrono::milliseconds>(c - b);
+		}
 
-			log << info << dur.count() << "ms\n";
+		d.pool->Reset(); //
+		d.Get() = _Value();
+
+		auto err = file_len > 0 ? _stage1(buf, file_len, thr_num) : _simdjson::error_code::EMPTY;
+
+		if (err == _simdjson::error_code::EMPTY) { // no lines.
+			d.Get() = Array::Make(d.pool);
+			return { true, 0 };
 		}
-		auto c = std::chrono::steady_clock::now();
-		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(c - _);
-		log << info << dur.count() << "ms\n";
+		if (err != _simdjson::error_code::SUCCESS) {
+			log << warn << "stage1 error : ";
+			log << warn << err << "\n";
+			if (err == _simdjson::error_code::UNCLOSED_STRING) {
+				log << warn << "unclosed string in line " << FindUnclosedLine(buf, file_len) << "\n";
+			}
+
+			return { false, 0 };
+		}
+
+		my_vector<int64_t> line_start;
+
+		if (!FindLines(buf, imple_.get(), line_start)) {
+			log << warn << "not valid ndjson\n";
+			return { false, 0 };
+		}
+
+		const uint64_t length = imple_->n_structural_indexes;
+
+		uint64_t* count_vec = (uint64_t*)calloc(length, sizeof(uint64_t));
+		if (!count_vec) {
+			log << warn << "calloc fail in parse_ndjson function.";
+			return { false, 0 };
+		}
+
+		auto a = std::chrono::steady_clock::now();
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(a - _);
+		log << info << "stage1 " << dur.count() << "ms\n";
+
+		LoadData2 p(pool.get());
+
+		bool ok = p.parse_ndjson(d.Get(), d.pool, buf, file_len, imple_.get(), line_start, count_vec, thr_num);
 
 		free(count_vec);
-		return  { true, length };
+
+		dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _);
+		log << info << dur.count() << "ms\n";
+
+		return { ok, ok ? length : 0 };
 	}
 	
 
@@ -4698,8 +6843,28 @@ namespace claujson {
 
 		uint64_t length = 0;
 
+		// big str -> parallel stage1, not fused -> same to parse. (is_valid2 pass) lazy or zero copy -> d keeps buf_.
+		if ((!fused_ || (thr_num > 1 && (str.length() >> 20) > 1) || d.IsLazy() || d.IsZeroCopy()) && str.length() <= _simdjson::_SIMDJSON_MAXSIZE_BYTES) {
+			char* buf = _get_buf(str.length());
+			if (!buf) {
+				log << warn << "memory alloc error\n";
+				return { false, 0 };
+			}
+			std::memcpy(buf, str.data(), str.length());
+
+			auto err = _stage1(buf, str.length(), thr_num);
+
+			if (err != _simdjson::error_code::SUCCESS) {
+				log << warn << "stage1 error : ";
+				log << warn << err << "\n";
+
+				return { false, 0 };
+			}
+
+			return _parse(d, buf, str.length(), imple_.get(), thr_num, fused_, buf_);
+		}
+
 		auto _ = std::chrono::steady_clock::now();
-		uint64_t* count_vec = nullptr;
 		{
 			auto x = test_.parse(str.data(), str.length());
 
@@ -4748,139 +6913,60 @@ namespace claujson {
 
 			//if (use_all_function)
 			
-			std::set<uint64_t> _set;
+			uint64_t part_count = 1; // one part -> start = { 0, length }, no pivots.
 			{
 				//my_vector<uint64_t> start(thr_num + 1);
-				my_vector<uint64_t> last(thr_num);
+				const uint64_t part_num = PartNum(length, thr_num); // parts > threads, threads take parts from the queue.
 
-				my_vector<int> start_state(thr_num);
-				my_vector<int> last_state(thr_num);
-				for (auto& x : start_state) { x = -1; }
-				for (auto& x : last_state) { x = -1; }
+				if (part_num > 1) {
+					std::set<uint64_t> _set;
+					const my_vector<uint64_t> pivot = FindPivots(pool.get(), buf, simdjson_imple_, length, part_num);
 
-				for (uint64_t i = 1; i < thr_num; ++i) {
-					uint64_t middle = length / thr_num * i;
-					for (uint64_t i = middle; i < length; ++i) {
-						if (buf[simdjson_imple_->structural_indexes[i]] == ',') {
-							middle = i; _set.insert(i); break;
-						}
+					for (uint64_t i = 1; i < part_num; ++i) {
+						uint64_t middle = pivot[i];
+						for (uint64_t i = middle; i < length; ++i) {
+							if (buf[simdjson_imple_->structural_indexes[i]] == ',') {
+								middle = i; _set.insert(i); break;
+							}
 
-						if (i == length - 1) {
-							middle = length;
+							if (i == length - 1) {
+								middle = length;
+							}
 						}
 					}
-				}
-
-				_set.insert(0);
-
-				start.resize(1 + _set.size());
-				last.resize(_set.size());
-
-				int count = 0;
-				for (auto x : _set) {
-					start[count] = x;
-					++count;
-				}
-				start[_set.size()] = length - 1;
-
-				for (uint64_t i = 0; i < _set.size(); ++i) {
-					last[i] = start[i + 1];
-				}
-
-				my_vector<Vector<int8_t>> is_array(_set.size()), is_virtual_array(_set.size());
-				my_vector<std::future<bool>> thr_result(_set.size());
-				count_vec = (uint64_t*)malloc(length * sizeof(uint64_t));
-				if (!count_vec) {
-					log << "malloc fail in parse_str function.";
-					return { false, -55 };
-				}
-				for (uint64_t i = 0; i < _set.size(); ++i) {
-					thr_result[i] = pool->enqueue(is_valid2, std::ref(test_), start[i], last[i], &start_state[i], &last_state[i],
-						&is_array[i], &is_virtual_array[i], count_vec);
-				}
-				my_vector<int> vec(_set.size());
-
-				for (uint64_t i = 0; i < _set.size(); ++i) {
-					vec[i] = (int)thr_result[i].get();
-				}
-
-				bool result = true;
-
-				for (uint64_t i = 0; i < vec.size(); ++i) {
-					if (vec[i] == false) {
-						free(count_vec); 
-						return { false, -1 };
-					}
-				}
-
-				for (uint64_t i = 0; i < _set.size() - 1; ++i) {
-					if (start_state[i + 1] != last_state[i]) {
-						free(count_vec); 
-						return { false, -2 };
-					}
-				}
-
-				if (is_virtual_array[0].empty() == false) { // first block has no virtual array or virtual object.!
-					free(count_vec); 
-					return { false, -3 };
-				}
 
-				for (uint64_t i = 1; i < _set.size(); ++i) {
-					if (is_array[0].empty()) {
-						free(count_vec);
-						return { false, -5 };
-					}
+					_set.insert(0);
 
-					if (false == is_virtual_array[i].empty()) {
-						//  
-						if (is_array[0].size() >= is_virtual_array[i].size()) {
-							for (uint64_t j = 0; j < is_virtual_array[i].size(); ++j) {
-								if (is_array[0].back() != is_virtual_array[i][j]) {
-									free(count_vec);
-									return { false, -3 };
-								}
-								is_array[0].pop_back();
-							}
-						}
-						else {
-							free(count_vec); 
-							return { false, -3 };
-						}
-					}
+					start.resize(1 + _set.size());
 
-					for (uint64_t x = 0; x < is_array[i].size(); ++x) {
-						is_array[0].push_back(is_array[i][x]);
+					int count = 0;
+					for (auto x : _set) {
+						start[count] = x;
+						++count;
 					}
-					
-					//is_array[0].insert(is_array[0].end(), is_array[i].begin(), is_array[i].end());
+					part_count = _set.size();
 				}
 
-				if (false == is_array[0].empty()) {
-					free(count_vec); 
-					return { false, -4 };
-
-				}
+				// no is_valid2 pass, __LoadData checks grammar. (count_vec == nullptr)
 			}
-			//else {
-			//	if (!is_valid(test, length)) {
-			//		free(count_vec); return { false, 0 };
-			//	}
-			//}
 
 			dur = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - b);
 			log << info << dur.count() << "ms\n";
 
 			b = std::chrono::steady_clock::now();
 
-			start[_set.size()] = length;
-			thr_num = _set.size();
+			start[part_count] = length;
+			thr_num = part_count;
+
+			d.input = nullptr; // not lazy or zero copy here.
 
 			LoadData2 p(pool.get());
 
-			if (false == p.parse(ut, d.pool, buf, buf_len, simdjson_imple_, length, start, count_vec,
-				thr_num)) // 0 : use all thread..
+			bool parse_ok = p.parse(ut, d.pool, buf, buf_len, simdjson_imple_, length, start, nullptr,
+				thr_num); // 0 : use all thread..
+			imbalance_ = p.imbalance;
+			if (false == parse_ok)
 			{
-				free(count_vec);
 				return { false, 0 };
 			}
 			auto c = std::chrono::steady_clock::now();
@@ -4891,7 +6977,6 @@ namespace claujson {
 		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(c - _);
 		log << info << dur.count() << "ms\n";
 
-		free(count_vec);
 		return  { true, length };
 	}
 
@@ -4930,6 +7015,123 @@ namespace claujson {
 		p.write_parallel2(fileName, j, thr_num, pretty);
 	}
 
+	extractor::extractor(int thr_num) {
+		pool = pool_init(thr_num);
+	}
+
+	// arr[from, to) -> col, from % 64 == 0. (parts do not share words of col->valid)
+	template <class T, class F>
+	static void ExtractColumn(const Array* arr, const my_vector<_Value>& path, uint64_t from, uint64_t to, Column<T>* col, F get) {
+		std::vector<KeyHandle> keys; // one KeyHandle per thread.
+		keys.reserve(path.size());
+		for (uint64_t k = 0; k < path.size(); ++k) {
+			keys.emplace_back(path[k]);
+		}
+
+		for (uint64_t i = from; i < to; ++i) {
+			const _Value* x = &arr->get_value_list(i);
+
+			for (uint64_t k = 0; k < path.size() && x; ++k) {
+				if (x->is_object()) {
+					x = &(*x->as_object())[keys[k]];
+				}
+				else if (x->is_array() && (path[k].is_int() || path[k].is_uint())) {
+					const uint64_t idx = path[k].get_unsigned_integer();
+					x = idx < x->as_array()->get_data_size() ? &x->as_array()->get_value_list(idx) : nullptr;
+				}
+				else {
+					x = nullptr;
+				}
+			}
+
+			if (x && x->is_valid() && get(*x, col->data[i])) {
+				col->valid[i >> 6] |= uint64_t(1) << (i & 63);
+			}
+		}
+	}
+
+	template <class T, class F>
+	static Column<T> ExtractColumn(ThreadPool* pool, const Array* arr, const my_vector<_Value>& path, uint64_t thr_num, F get) {
+		Column<T> col;
+		if (!arr) {
+			return col;
+		}
+
+		const uint64_t n = arr->get_data_size();
+		col.data.resize(n);
+		col.valid.resize((n + 63) / 64, 0);
+
+		if (thr_num <= 0) {
+			thr_num = std::max((int)std::thread::hardware_concurrency() - 2, 1);
+		}
+
+		const uint64_t min_chunk = 4096;
+		uint64_t chunk = ((n + thr_num - 1) / thr_num + 63) / 64 * 64;
+		if (chunk < min_chunk) {
+			chunk = min_chunk;
+		}
+
+		if (thr_num <= 1 || n <= chunk) {
+			ExtractColumn(arr, path, 0, n, &col, get);
+			return col;
+		}
+
+		std::vector<std::future<void>> result;
+		for (uint64_t from = 0; from < n; from += chunk) {
+			const uint64_t to = std::min(n, from + chunk);
+			result.push_back(pool->enqueue([arr, &path, from, to, &col, get]() {
+				ExtractColumn(arr, path, from, to, &col, get);
+			}));
+		}
+		for (auto& x : result) {
+			x.get();
+		}
+		return col;
+	}
+
+	Column<double> extractor::get_float(const Array* arr, const my_vector<_Value>& path, uint64_t thr_num) {
+		return ExtractColumn<double>(pool.get(), arr, path, thr_num, [](const _Value& x, double& out) {
+			if (x.is_float()) {
+				out = x.float_val();
+			}
+			else if (x.is_int()) {
+				out = static_cast<double>(x.int_val());
+			}
+			else if (x.is_uint()) {
+				out = static_cast<double>(x.uint_val());
+			}
+			else {
+				return false;
+			}
+			return true;
+		});
+	}
+
+	Column<int64_t> extractor::get_int(const Array* arr, const my_vector<_Value>& path, uint64_t thr_num) {
+		return ExtractColumn<int64_t>(pool.get(), arr, path, thr_num, [](const _Value& x, int64_t& out) {
+			if (x.is_int()) {
+				out = x.int_val();
+			}
+			else if (x.is_uint() && x.uint_val() <= static_cast<uint64_t>(INT64_MAX)) {
+				out = static_cast<int64_t>(x.uint_val());
+			}
+			else {
+				return false;
+			}
+			return true;
+		});
+	}
+
+	Column<StringView> extractor::get_string(const Array* arr, const my_vector<_Value>& path, uint64_t thr_num) {
+		return ExtractColumn<StringView>(pool.get(), arr, path, thr_num, [](const _Value& x, StringView& out) {
+			if (!x.is_str()) {
+				return false;
+			}
+			out = StringView(x.get_string().data(), x.get_string().size());
+			return true;
+		});
+	}
+
 	static std::string escape_for_json_pointer(std::string str) {
 		// 1. ~ -> ~0
 		// 2. / -> ~1
@@ -5268,6 +7470,56 @@ namespace claujson {
 		return _diff(pool, x, y, vec);
 	}
 
+	// x -> none, strings, arrays and objects of x go back to their Arena. (for patch, x is not used after)
+	static void Release(_Value& x) {
+		if (x.is_array()) {
+			Array* arr = x.as_array();
+			for (uint64_t i = 0; i < arr->get_data_size(); ++i) {
+				Release(arr->get_value_list(i));
+			}
+			Arena* pool = arr->get_pool();
+			if (pool) {
+				arr->~Array();
+				pool->deallocate<Array>(arr, 1);
+			}
+			else {
+				delete arr;
+			}
+			x.set_none();
+		}
+		else if (x.is_object()) {
+			Object* obj = x.as_object();
+			StructuredPtr ptr = x;
+			Arena* pool = obj->get_pool();
+			for (uint64_t i = 0; i < obj->get_data_size(); ++i) {
+				Release(ptr.get_value_list(i));
+				ptr.get_key_list(i).clear(true); // shared keys are kept by String::clear.
+			}
+			if (pool) {
+				obj->~Object();
+				pool->deallocate<Object>(obj, 1);
+			}
+			else {
+				delete obj;
+			}
+			x.set_none();
+		}
+		else if (x.is_str()) {
+			x.clear(true);
+		}
+	}
+
+	// path of diff, (in heap) removed after json_pointerB.
+	struct PatchPath {
+		my_vector<_Value> vec;
+
+		~PatchPath() {
+			for (uint64_t i = 0; i < vec.size(); ++i) {
+				vec[i].clear(true);
+			}
+		}
+	};
+
 	//
 	_Value& patch(Arena* pool, _Value& x, const _Value& diff) {
 		static _Value unvalid_data(nullptr, false);
@@ -5313,28 +7565,31 @@ namespace claujson {
 					return unvalid_data;
 				}
 
-				my_vector<_Value> vec;
+				PatchPath path;
+				my_vector<_Value>& vec = path.vec;
 				const Array* arr = obj->get_value_list(path_idx).as_array();
 				if (arr == nullptr) {
 				//	clean(result);
 					return unvalid_data;
 				}
 				for (uint64_t i = 0; i < arr->size(); ++i) {
-					vec.push_back(arr->get_value_list(i).clone(pool));
+					vec.push_back(arr->get_value_list(i).clone(nullptr));
 				}
 				_Value& value = result.json_pointerB(vec);
 
+				Release(value);
 				value = obj->get_value_list(value_idx).clone(pool); // clone -> std::move(~~)??
 			}
 			else if (obj->get_value_list(op_idx).str_val() == "remove"sv) {
-				my_vector<_Value> vec;
+				PatchPath path;
+				my_vector<_Value>& vec = path.vec;
 				const Array* arr = obj->get_value_list(path_idx).as_array();
 				if (arr == nullptr) {
 					//clean(result);
 					return unvalid_data;
 				}
 				for (uint64_t i = 0; i < arr->size(); ++i) {
-					vec.push_back(arr->get_value_list(i).clone(pool));
+					vec.push_back(arr->get_value_list(i).clone(nullptr));
 				}
 				_Value& value = result.json_pointerB(vec);
 				_Value& parent = value;
@@ -5342,7 +7597,7 @@ namespace claujson {
 				// case : result.json_pointer returns root?
 				if (!parent) {
 					if (result.is_structured()) {
-						//clean(result);
+						Release(result);
 					}
 					result.clear(false);
 				}
@@ -5355,7 +7610,7 @@ namespace claujson {
 
 					uint64_t last_idx = obj->get_value_list(last_idx_idx).uint_val();
 
-				//	claujson::clean(parent.as_array()->get_value_list(last_idx));
+					Release(parent.as_array()->get_value_list(last_idx));
 					parent.as_array()->erase(last_idx);
 				}
 				else {
@@ -5367,7 +7622,9 @@ namespace claujson {
 
 					const _Value& last_key = obj->get_value_list(last_key_idx);
 					uint64_t _idx = parent.as_object()->find(last_key);
-					//claujson::clean(parent.as_object()->get_value_list(_idx));
+					if (_idx != Object::npos) { // key is kept, (used by index of object in erase)
+						Release(parent.as_object()->get_value_list(_idx));
+					}
 					parent.as_object()->erase(_idx);
 				}
 			}
@@ -5377,14 +7634,15 @@ namespace claujson {
 					return unvalid_data;
 				}
 
-				my_vector<_Value> vec;
+				PatchPath path;
+				my_vector<_Value>& vec = path.vec;
 				const Array* arr = obj->get_value_list(path_idx).as_array();
 				if (arr == nullptr) {
 					//clean(result);
 					return unvalid_data;
 				}
 				for (uint64_t i = 0; i < arr->size(); ++i) {
-					vec.push_back(arr->get_value_list(i).clone(pool));
+					vec.push_back(arr->get_value_list(i).clone(nullptr));
 				}
 
 				_Value& _ = result.json_pointerB(vec);
@@ -5394,6 +7652,7 @@ namespace claujson {
 
 					// case : result.json_pointer returns root?
 					if (!parent) {
+						Release(result);
 						result = obj->get_value_list(value_idx).clone(pool);
 					}
 					else if (parent.is_array()) {
@@ -5634,7 +7893,7 @@ namespace claujson {
 	}
 
 	bool convert_string(StringView x, claujson::_Value& data) {
-		return ConvertString(nullptr, data, x.data(), x.size());
+		return ConvertString(nullptr, data, x.data(), x.size(), false, nullptr);
 	}
 	*/
 #if __cpp_lib_char8_t
@@ -6,6 +6,7 @@
 #include "claujson_string.h"
 
 #include "thread_pool.h"
+#include <functional>
 
 #include "_simdjson.h" // modified simdjson // using simdjson 3.12.3
 
@@ -15,6 +16,7 @@ namespace claujson {
 	class Object;
 	class PartialJson;
 	class StructuredPtr;
+	class KeyHandle;
 
 
 	//only used in Array, and Object, (parent Pointer + is_virtual?)
@@ -73,10 +75,14 @@ namespace claujson {
 	public:
 		friend std::ostream& operator<<(std::ostream& stream, const _Value& data);
 
-		friend bool ConvertString(Arena* pool, _Value& data, const char* text, uint64_t len);
+		friend bool ConvertString(Arena* pool, _Value& data, const char* text, uint64_t len, bool key, const _Value* shape_key);
+		friend _Value& Convert(Arena* pool, _Value& data, uint64_t buf_idx, uint64_t next_buf_idx, bool key,
+			char* buf, uint64_t token_idx, bool& err, const _Value* shape_key);
+		friend class Document;
 
 		friend class Object;
 		friend class Array;
+		friend class LoadData2;
 	private:
 
 		// do not change!
@@ -153,7 +159,7 @@ namespace claujson {
 			*this->_str_val = std::move(x);
 		}
 	public:
-		_ValueType type() const;
+		_ValueType type() const; // LAZY_NUMBER, LAZY_STRING -> converted.
 
 		bool is_valid() const;
 
@@ -259,6 +265,9 @@ namespace claujson {
 		_Value& operator[](const _Value& key); // if not exist key, then nothing.
 		const _Value& operator[](const _Value& key) const; // if not exist key, then nothing.
 
+		_Value& operator[](const KeyHandle& key); // if not exist key, then nothing.
+		const _Value& operator[](const KeyHandle& key) const; // if not exist key, then nothing.
+
 
 		_Value& operator[](uint64_t idx);
 		const _Value& operator[](uint64_t idx) const;
@@ -288,6 +297,14 @@ namespace claujson {
 		bool set_str(String str);
 	private:
 		void set_str_in_parse(Arena* pool, const char* str, uint64_t len);
+		// str is interned if key interning of pool is on.
+		void set_key_in_parse(Arena* pool, const char* str, uint64_t len);
+		// text -> '"', unescaped into pool directly, len is length of token. (for ConvertString)
+		bool set_str_unescape(Arena* pool, const char* text, uint64_t len, bool key, const _Value* shape_key);
+		// String (and buffer) -> pool, buffer not own is kept.
+		void release_str();
+		// shared buffer of key -> same key in table of pool, if found. (after tables of parts are merged)
+		void remap_key(const Arena* pool);
 	public:
 		void set_bool(bool x);
 		
@@ -324,6 +341,20 @@ namespace claujson {
 	private:
 		void set_type(_ValueType type);
 
+		// lazy value -> _type is read/written with acquire/release, (converted by one thread, read by others)
+		_ValueType load_type() const;
+		void store_type(_ValueType type);
+
+		// text points to input kept in pool, (parsing with lazy)
+		void set_lazy_number(const char* text);
+		bool set_lazy_str(Arena* pool, const char* text, uint64_t len);
+		// text -> '"' of input kept in pool, if no escape and not short, then String points to input. (no copy)
+		bool set_str_zero_copy(Arena* pool, char* text, uint64_t len);
+		// convert lazy value, once. if fail, then ERROR.
+		_ValueType resolve() const;
+		// LAZY_STRING, token in input -> unescaped into same String, buffer from pool. (for resolve)
+		bool resolve_str(Arena* pool) const;
+
 	public:
 		~_Value();
 
@@ -350,6 +381,19 @@ namespace claujson {
 		bool is_virtual() const;
 	};
 
+	// key + idx of last find, for lookups of same key in objects of same shape. (ex) features of citylots)
+	// key must live longer than KeyHandle. one KeyHandle per thread.
+	class KeyHandle {
+		friend class Object;
+	private:
+		const _Value* key;
+		mutable uint64_t hint = 0; // try this idx first.
+	public:
+		explicit KeyHandle(const _Value& key) : key(&key) {}
+
+		const _Value& get() const { return *key; }
+	};
+
 	class Value {
 	private:
 		_Value x;
@@ -409,6 +453,10 @@ namespace claujson {
 	private:
 		_Value x;
 		Arena* pool; // getter? public?
+		bool lazy = false;
+		bool zero_copy = false;
+		bool sharded = false;
+		std::shared_ptr<void> input; // lazy or zero copy -> buffer of parser or mapped file, values point to it.
 	public:
 		Document(uint64_t size = Arena::initialSize) noexcept { pool = new (std::nothrow) Arena(size); }
 
@@ -416,7 +464,8 @@ namespace claujson {
 			pool = new (std::nothrow) Arena(size);
 		}
 
-		Document(Document&& d) noexcept : x(std::move(d.x)), pool(d.pool) { d.pool = nullptr; }
+		Document(Document&& d) noexcept : x(std::move(d.x)), pool(d.pool), lazy(d.lazy), zero_copy(d.zero_copy), sharded(d.sharded),
+			input(std::move(d.input)) { d.pool = nullptr; }
 
 		~Document() noexcept;
 	public:
@@ -425,12 +474,86 @@ namespace claujson {
 	public:
 		_Value& Get() noexcept { return x; }
 		const _Value& Get() const noexcept { return x; }
+		// with shards -> Arena of calling thread.
 		Arena* GetAllocator() noexcept {
-			return pool;
+			return sharded && pool ? pool->GetShard() : pool;
 		}
 		const Arena* GetAllocator() const noexcept {
 			return pool;
 		}
+
+		// blocks of this Document are 2MB huge pages (transparent, linux) and/or prefaulted at creation, call before parse.
+		void EnableHugePage(bool on, bool prefault = false) {
+			if (pool) {
+				pool->SetPageMode((on ? Arena::Block::HugePage : 0) | (prefault ? Arena::Block::Prefault : 0));
+			}
+		}
+
+		// GetAllocator gives own Arena (shard) to each thread, then threads can add values to disjoint subtrees at the same time.
+		// shards are merged at parse, or MergeShards (when no thread uses GetAllocator). off by default.
+		void EnableShards(bool on) {
+			sharded = on;
+		}
+
+		bool IsSharded() const {
+			return sharded;
+		}
+
+		void MergeShards() {
+			if (pool) {
+				pool->MergeShards();
+			}
+		}
+
+		// max bytes of blocks kept for reuse after Reset, (in parse) 0 -> as much as blocks in use before.
+		void SetRetainLimit(uint64_t bytes) {
+			if (pool) {
+				pool->SetRetainLimit(bytes);
+			}
+		}
+
+		// memory used by this Document, (ex) to choose size of Document(size))
+		ArenaStats GetStats() const {
+			return pool ? pool->GetStats() : ArenaStats();
+		}
+
+		// keys of objects (size >= 11) share one copy in this Document, call before parse. off by default.
+		void EnableKeyIntern(bool on) {
+			if (pool) {
+				pool->EnableKeyIntern(on);
+			}
+		}
+
+		// object shares key Strings with object of same layout before it (ex) records of array), call before parse. off by default.
+		// shared keys -> do not change keys by set_str, set_int, ..., use Object::change_key.
+		void EnableShapeShare(bool on) {
+			if (pool) {
+				pool->EnableShapeShare(on);
+			}
+		}
+
+		// key for Object::find, interned -> find compares pointers first.
+		_Value MakeKey(StringView key);
+
+		// numbers and strings(not keys) are converted at first access, input is kept by Document. (not copied) call before parse. off by default.
+		// errors in numbers, strings -> found at access, (the value is ERROR, not valid). not for parse_pipelined, parse_ndjson, parse_stream.
+		void EnableLazy(bool on) {
+			lazy = on;
+		}
+
+		bool IsLazy() const {
+			return lazy;
+		}
+
+		// strings(not keys, size >= 11) without escape point to input kept by Document, not copied. call before parse. off by default.
+		// lazy -> always.
+		void EnableZeroCopy(bool on) {
+			zero_copy = on;
+		}
+
+		bool IsZeroCopy() const {
+			return zero_copy;
+		}
 	};
 }
 
@@ -611,20 +734,22 @@ namespace claujson {
 		bool assign_value(uint64_t idx, Value val);
 
 
-		void MergeWith(StructuredPtr j, int start_offset);
+		void MergeWith(StructuredPtr j, int start_offset, bool update_parent = true); // update_parent == false -> only parent of last item is updated.
 
 		void reserve_data_list(uint64_t sz);
+		void shrink_data_list();
 
 	private:
 		// need rename param....!
+		// shape_key : key at same idx of object of same layout, (nullptr -> none)
 		void add_item_type(int64_t key_buf_idx, int64_t key_next_buf_idx, int64_t val_buf_idx, int64_t val_next_buf_idx,
-			char* buf, uint64_t key_token_idx, uint64_t val_token_idx, Arena* pool);
+			char* buf, uint64_t key_token_idx, uint64_t val_token_idx, Arena* pool, const _Value* shape_key = nullptr);
 
 		void add_item_type(int64_t val_buf_idx, int64_t val_next_buf_idx,
 			char* buf, uint64_t val_token_idx, Arena* pool);
 
 		void add_user_type(int64_t key_buf_idx, int64_t key_next_buf_idx, char* buf,
-			_ValueType type, uint64_t key_token_idx, Arena* pool
+			_ValueType type, uint64_t key_token_idx, Arena* pool, const _Value* shape_key = nullptr
 		);
 
 		//
@@ -656,13 +781,62 @@ namespace claujson {
 	class parser {
 	private:
 		_simdjson::dom::parser_for_claujson test_;
+		std::unique_ptr<_simdjson::internal::dom_parser_implementation> imple_; // stage1 for parse_mmap, parse_pipelined
+		std::unique_ptr<_simdjson::internal::dom_parser_implementation> chunk_imple_; // stage1 for one chunk, parse_pipelined
+		std::vector<std::unique_ptr<_simdjson::internal::dom_parser_implementation>> range_imples_; // parallel stage1
+		std::shared_ptr<char> buf_; // padded input, for parallel stage1. (kept by Document for lazy or zero copy)
+		uint64_t buf_capacity_ = 0;
+		std::unique_ptr<uint64_t[]> count_vec_; // count of items of containers, is_valid2 pass of _parse
+		uint64_t count_vec_capacity_ = 0;
+		double imbalance_ = 1.0;
+		bool fused_ = false;
 		std::unique_ptr<ThreadPool> pool;
 	public:
 		parser(int thr_num = 0);
+
+		// slowest / average time of tree building parts, in last parse or parse_str. (1.0 -> balanced)
+		double get_imbalance() const { return imbalance_; }
+
+		// parse_str checks grammar while building the tree. (one pass) off -> is_valid2 pass before, like parse. off by default,
+		// is_valid2 pass gives count of each container -> exact reserve, it is faster than one pass in our benchmark.
+		void set_fused(bool on) { fused_ = on; }
+	private:
+		// stage1 -> imple_, buf is padded. (use thr_num threads if buf is big)
+		_simdjson::error_code _stage1(const char* buf, uint64_t buf_len, uint64_t thr_num);
+
+		// use buf_ (buf_len + _SIMDJSON_PADDING), new one if it is kept by Document.
+		char* _get_buf(uint64_t buf_len);
+
+		// lazy or zero copy -> d keeps owner of buf, values point to it. (no owner -> copy in Arena of d)
+		static char* _keep_input(Document& d, char* buf, uint64_t buf_len, std::shared_ptr<void> owner);
+
+		// use count_vec_ (len), kept for next parse.
+		uint64_t* _get_count_vec(uint64_t len);
+
+		// buf, buf_len, simdjson_imple_ <- after stage1.
+		// fused -> no is_valid2 pass, grammar is checked while building the tree. owner of buf -> kept by d. (_keep_input)
+		std::pair<bool, uint64_t> _parse(Document& d, char* buf, uint64_t buf_len,
+			_simdjson::internal::dom_parser_implementation* simdjson_imple_, uint64_t thr_num, bool fused = false,
+			std::shared_ptr<void> owner = nullptr);
 	public:
 		// parse json file.
 		std::pair<bool, uint64_t> parse(const std::string& fileName, Document& d, uint64_t thr_num);
 
+		// parse json file, using memory-mapped file, no copy to scanner buffer. (windows -> same to parse)
+		std::pair<bool, uint64_t> parse_mmap(const std::string& fileName, Document& d, uint64_t thr_num);
+
+		// parse json file, stage1 (chunk by chunk) and tree building are overlapped. (windows -> same to parse)
+		std::pair<bool, uint64_t> parse_pipelined(const std::string& fileName, Document& d, uint64_t thr_num);
+
+		// parse ndjson (json lines) file, d.Get() is array of values of lines.
+		std::pair<bool, uint64_t> parse_ndjson(const std::string& fileName, Document& d, uint64_t thr_num);
+
+		// parse json file (root is array or object) window by window, values of root -> callback(key, value) in order.
+		// key is NONE if root is array. key, value are valid only in callback. callback returns false -> stop.
+		// memory use ~ window_size (grows if a value of root is bigger than window_size)
+		std::pair<bool, uint64_t> parse_stream(const std::string& fileName, const std::function<bool(_Value& key, _Value& value)>& callback,
+			uint64_t window_size, uint64_t thr_num);
+
 		//std::pair<bool, uint64_t> parse2(const std::string& fileName, Document2*& j, uint64_t thr_num);
 		
 		// parse json str.
@@ -689,6 +863,32 @@ namespace claujson {
 		void write_parallel2(const std::string& fileName, const _Value& j, uint64_t thr_num, bool pretty = false);
 	};
 
+	// values of a field of items of an array, in contiguous buffer.
+	template <class T>
+	class Column {
+	public:
+		std::vector<T> data; // data[i] <- arr[i] with path, T() if not valid.
+		std::vector<uint64_t> valid; // validity bitmap, bit (i % 64) of valid[i / 64] -> data[i] is valid.
+	public:
+		uint64_t size() const { return data.size(); }
+		bool is_valid(uint64_t i) const { return (valid[i >> 6] >> (i & 63)) & 1; }
+	};
+
+	// columnar extraction, arr[i] -> path (like json_pointerB, key for object, idx for array) -> column[i].
+	class extractor {
+	private:
+		std::unique_ptr<ThreadPool> pool;
+	public:
+		extractor(int thr_num = 0);
+	public:
+		// int, uint, float -> double.
+		Column<double> get_float(const Array* arr, const my_vector<_Value>& path, uint64_t thr_num);
+		// int, uint (<= INT64_MAX) -> int64_t.
+		Column<int64_t> get_int(const Array* arr, const my_vector<_Value>& path, uint64_t thr_num);
+		// string -> StringView, valid while arr is not changed.
+		Column<StringView> get_string(const Array* arr, const my_vector<_Value>& path, uint64_t thr_num);
+	};
+
 
 	[[nodiscard]]
 	_Value diff(Arena* pool, const _Value& x, const _Value& y);
@@ -722,6 +922,7 @@ namespace claujson {
 	} while (false) 
 
 namespace claujson {
+	// shape_key : key is same -> data shares buffer of shape_key, (own String)
 	claujson::_Value& Convert(Arena* pool, claujson::_Value& data, uint64_t buf_idx, uint64_t next_buf_idx, bool key,
-			char* buf, uint64_t token_idx, bool& err);
+			char* buf, uint64_t token_idx, bool& err, const _Value* shape_key = nullptr);
 }
@@ -34,7 +34,7 @@ namespace claujson {
 		if (pool) {
 			temp = (Array*)pool->allocate<Array>(sizeof(Array), alignof(Array)); // new (std::nothrow) Array();
 			new (temp) Array();
-			temp->arr_vec = my_vector<_Value>(pool, 0, 2);
+			temp->arr_vec = my_vector<_Value>(pool, 0, 0); // allocated at reserve_data_list or first push_back.
 		}
 		else {
 			temp = new (std::nothrow) Array();
@@ -53,7 +53,7 @@ namespace claujson {
 		if (pool) {
 			temp = (Array*)pool->allocate<Array>(sizeof(Array), alignof(Array)); // new (std::nothrow) Array();
 			new (temp) Array();
-			temp->arr_vec = my_vector<_Value>(pool, 0, 2);
+			temp->arr_vec = my_vector<_Value>(pool, 0, 0); // allocated at reserve_data_list or first push_back.
 		}
 		else {
 			temp = new (std::nothrow) Array();
@@ -117,6 +117,9 @@ namespace claujson {
 	uint64_t Array::get_data_size() const {
 		return arr_vec.size();
 	}
+	uint64_t Array::get_data_capacity() const {
+		return arr_vec.capacity();
+	}
 
 	_Value& Array::get_value_list(uint64_t idx) {
 		return arr_vec[idx];
@@ -158,6 +161,9 @@ namespace claujson {
 	void Array::reserve_data_list(uint64_t len) {
 		arr_vec.reserve(len);
 	}
+	void Array::shrink_data_list() {
+		arr_vec.shrink_to_fit();
+	}
 
 
 	Array::_ValueIterator Array::begin() {
@@ -239,11 +245,11 @@ namespace claujson {
 	}
 
 
-	void Array::MergeWith(Array* j, int start_offset) {
+	void Array::MergeWith(Array* j, int start_offset, bool update_parent) {
 		auto* x = j;
 
 		uint64_t len = j->get_data_size();
-		for (uint64_t i = 0; i < len; ++i) {
+		for (uint64_t i = (update_parent || len == 0) ? 0 : len - 1; i < len; ++i) {
 			if (j->get_value_list(i).is_array()) {
 				j->get_value_list(i).as_array()->set_parent(this);
 			}
@@ -261,10 +267,10 @@ namespace claujson {
 			log << info << "test3";
 		}
 	}
-	void Array::MergeWith(Object* j, int start_offset) {
+	void Array::MergeWith(Object* j, int start_offset, bool update_parent) {
 		ERROR("Array::MergeWith Error");
 	}
-	void Array::MergeWith(PartialJson* j, int start_offset) {
+	void Array::MergeWith(PartialJson* j, int start_offset, bool update_parent) {
 		auto* x = j;
 
 		if (x->obj_data.empty() == false) { // not object?
@@ -272,7 +278,7 @@ namespace claujson {
 		}
 
 		uint64_t len = j->get_data_size();
-		for (uint64_t i = 0; i < len; ++i) {
+		for (uint64_t i = (update_parent || len == 0) ? 0 : len - 1; i < len; ++i) {
 			if (j->get_value_list(i).is_array()) {
 				j->get_value_list(i).as_array()->set_parent(this);
 			}
@@ -54,6 +54,7 @@ namespace claujson {
 	public:
 
 		void reserve_data_list(uint64_t len); // if object, reserve key_list and value_list, if array, reserve value_list.
+		void shrink_data_list(); // capacity -> size.
 
 		// for valid with object or array or root.
 		uint64_t size() const {
@@ -64,6 +65,7 @@ namespace claujson {
 		}
 
 		uint64_t get_data_size() const;
+		uint64_t get_data_capacity() const;
 
 		_Value& get_value_list(uint64_t idx);
 	private:
@@ -100,9 +102,9 @@ namespace claujson {
 	private:
 		// here only used in parsing.
 
-		void MergeWith(Array* j, int start_offset);
-		void MergeWith(Object* j, int start_offset);
-		void MergeWith(PartialJson* j, int start_offset);
+		void MergeWith(Array* j, int start_offset, bool update_parent = true);
+		void MergeWith(Object* j, int start_offset, bool update_parent = true);
+		void MergeWith(PartialJson* j, int start_offset, bool update_parent = true);
 
 		void add_item_type(int64_t key_buf_idx, int64_t key_next_buf_idx, int64_t val_buf_idx, int64_t val_next_buf_idx,
 			char* buf, uint64_t key_token_idx, uint64_t val_token_idx);
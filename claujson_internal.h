@@ -10,6 +10,12 @@
 #include <fstream>
 #include <cstring>
 #include <cstdint> // uint64_t? int64_t?
+#include <atomic>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 
 template <class From, class To>
@@ -503,7 +509,8 @@ namespace claujson {
 		NULL_,
 		STRING, SHORT_STRING,
 		NOT_VALID,
-		ERROR // private class?
+		ERROR, // private class?
+		LAZY_NUMBER, LAZY_STRING // not converted yet, converted at first access. (Document::EnableLazy)
 	};
 
 	template <class Key, class Data>
@@ -522,41 +529,99 @@ namespace claujson {
 	template <class Block>
 	class BlockManager { // manager for not using?
 	public: // or friend? or set_~~ 
-		// start_block-> ...->last_block(or nullptr)
+		// start_block-> ...->last_block(or nullptr), blocks given back, not in bucket yet.
 		Block* start_block = nullptr;
 		Block* last_block = nullptr;
+	private:
+		// bucket[k] : blocks of 2^k <= capacity < 2^(k+1)
+		static const int bucketNum = 64;
+		Block* bucket[bucketNum] = {};
+		uint64_t bucket_bytes = 0;
+
+		static int Log2(uint64_t x) {
+			int k = 0;
+			while (x >>= 1) {
+				++k;
+			}
+			return k;
+		}
+
+		// start_block ~ last_block -> bucket
+		void Sort() {
+			Block* block = start_block;
+			while (block) {
+				Block* next = block->next;
+				const int k = Log2(block->capacity);
+				block->next = bucket[k];
+				bucket[k] = block;
+				bucket_bytes += block->capacity;
+				block = next;
+			}
+			start_block = nullptr;
+			last_block = nullptr;
+		}
+
+		Block* Pop(int k) {
+			Block* block = bucket[k];
+			bucket[k] = block->next;
+			bucket_bytes -= block->capacity;
+			block->offset = 0;
+			block->next = nullptr;
+			return block;
+		}
 	public:
+		// block of capacity >= cap, from bucket of cap or next bucket. (else new block)
 		[[nodiscard]]
-		Block* Get(uint64_t cap) {
-			if (!start_block) {
-				start_block = new (std::nothrow)Block(cap);
-				if (start_block == nullptr) { return nullptr; }
-				Block* result = start_block;
-				start_block = nullptr;
-				return result;
+		Block* Get(uint64_t cap, int mode = 0) {
+			Sort();
+
+			const int k = Log2(cap);
+			if (bucket[k] && bucket[k]->capacity >= cap) {
+				return Pop(k);
 			}
-			Block* block = start_block;
-			Block* before_block = nullptr;
-	
-			while (block && (block->capacity != cap)) {
-				before_block = block;
-				block = block->next;
+			if (k + 1 < bucketNum && bucket[k + 1]) {
+				return Pop(k + 1);
 			}
-			if (block) {
-				if (before_block) {
-					before_block->next = block->next;
+			return new(std::nothrow)Block(cap, mode);
+		}
+
+		// blocks are deleted (memory to OS) until kept bytes <= limit, bigger blocks first.
+		void Trim(uint64_t limit) {
+			Sort();
+
+			for (int k = bucketNum - 1; k >= 0 && bucket_bytes > limit; --k) {
+				while (bucket[k] && bucket_bytes > limit) {
+					delete Pop(k);
 				}
-				else { // 
-					start_block = block->next;
-					if (start_block == nullptr) {
-						last_block = nullptr;
-					}
+			}
+		}
+
+		// blocks of other -> this.
+		void Merge(BlockManager& other) {
+			other.Sort();
+
+			for (int k = 0; k < bucketNum; ++k) {
+				while (other.bucket[k]) {
+					Block* block = other.Pop(k);
+					block->next = bucket[k];
+					bucket[k] = block;
+					bucket_bytes += block->capacity;
+				}
+			}
+		}
+
+		// number and capacity of blocks kept.
+		void Stats(uint64_t& num, uint64_t& bytes) const {
+			for (const Block* block = start_block; block; block = block->next) {
+				num++;
+				bytes += block->capacity;
+			}
+			for (int k = 0; k < bucketNum; ++k) {
+				for (const Block* block = bucket[k]; block; block = block->next) {
+					num++;
 				}
-				block->offset = 0;
-				block->next = nullptr;
-				return block;
 			}
-			return new(std::nothrow)Block(cap);
+			bytes += bucket_bytes;
 		}
 	public:
 		BlockManager(Block* start_block = nullptr, Block* last_block = nullptr) : start_block(start_block), last_block(last_block) {
@@ -568,14 +633,111 @@ namespace claujson {
 		// check last_block?, has bug?
 		void RemoveBlocks() {
 			//t64_t count = 0;
-			Block* block = start_block;
-			while (block) {
-				Block* next = block->next;
-				delete block;
-				block = next;
-				//unt++;
-			}	//d::cout << "count1 " << count << " \n";
+			Sort();
+			for (int k = 0; k < bucketNum; ++k) {
+				while (bucket[k]) {
+					delete Pop(k);
+				}
+			}
+			//d::cout << "count1 " << count << " \n";
+		}
+	};
+
+	// interned keys of an Arena, key -> one copy in the Arena. (open addressing, load factor <= 0.5)
+	class KeyTable {
+	public:
+		struct Entry {
+			char* str = nullptr; // nullptr -> empty slot.
+			uint32_t sz = 0;
+			uint32_t hash = 0;
+		};
+	private:
+		std::vector<Entry> slots;
+		uint64_t count = 0;
+	public:
+		static uint32_t Hash(const char* str, uint64_t sz) {
+			uint64_t h = 14695981039346656037ULL; // FNV-1a
+			for (uint64_t i = 0; i < sz; ++i) {
+				h ^= static_cast<uint8_t>(str[i]);
+				h *= 1099511628211ULL;
+			}
+			return static_cast<uint32_t>(h ^ (h >> 32));
+		}
+
+		char* find(const char* str, uint32_t sz, uint32_t hash) const {
+			if (slots.empty()) {
+				return nullptr;
+			}
+			const uint64_t mask = slots.size() - 1;
+			for (uint64_t i = hash & mask; slots[i].str; i = (i + 1) & mask) {
+				if (slots[i].hash == hash && slots[i].sz == sz && memcmp(slots[i].str, str, sz) == 0) {
+					return slots[i].str;
+				}
+			}
+			return nullptr;
+		}
+
+		// entry.str is not in table.
+		void insert(const Entry& entry) {
+			if ((count + 1) * 2 > slots.size()) {
+				std::vector<Entry> temp(slots.empty() ? 64 : slots.size() * 2);
+				std::swap(temp, slots);
+				count = 0;
+				for (const auto& x : temp) {
+					if (x.str) {
+						insert(x);
+					}
+				}
+			}
+			const uint64_t mask = slots.size() - 1;
+			uint64_t i = entry.hash & mask;
+			while (slots[i].str) {
+				i = (i + 1) & mask;
+			}
+			slots[i] = entry;
+			++count;
+		}
+
+		// from other table, same key -> this one is kept, other one is not added. (-> copies if not nullptr)
+		void merge(const KeyTable& other, std::vector<Entry>* copies = nullptr) {
+			for (const auto& x : other.slots) {
+				if (!x.str) {
+					continue;
+				}
+				if (!find(x.str, x.sz, x.hash)) {
+					insert(x);
+				}
+				else if (copies) {
+					copies->push_back(x);
+				}
+			}
 		}
+
+		void clear() {
+			slots.clear();
+			count = 0;
+		}
+
+		uint64_t size() const {
+			return count;
+		}
+	};
+
+	// memory of Arena and Arenas linked to it. [0] : list of default size blocks, [1] : list of oversize blocks.
+	struct ArenaStats {
+		uint64_t block_num[2] = { 0, 0 }; // blocks in use.
+		uint64_t reserved[2] = { 0, 0 }; // capacity of blocks in use.
+		uint64_t used[2] = { 0, 0 }; // allocated bytes of blocks in use, (includes deallocated memory in free lists)
+		uint64_t recycled_block_num[2] = { 0, 0 }; // blocks kept in BlockManager for reuse.
+		uint64_t recycled[2] = { 0, 0 }; // capacity of them.
+		uint64_t free_num = 0; // chunks in free lists.
+		uint64_t free_bytes = 0; // bytes of them.
+		uint64_t oversize_num = 0; // allocations that needed own block, since Reset or Clear.
+		uint64_t regrow_num = 0; // Vector2 (data of Array, Object..) moved to bigger memory, since Reset or Clear.
+		uint64_t arena_num = 0; // this and linked Arenas.
+
+		uint64_t total_reserved() const { return reserved[0] + reserved[1] + recycled[0] + recycled[1]; }
+		uint64_t total_used() const { return used[0] + used[1] - free_bytes; }
 	};
 
 	// bug - 크기를 줄일떄? 메모리 소비?
@@ -588,13 +750,63 @@ namespace claujson {
 			uint64_t offset;
 			uint8_t* data;
 			
-			Block(uint64_t cap)
+			bool mapped = false; // data from mmap, (huge page)
+
+			// mode of data, HugePage -> mmap, 2MB aligned and capacity is rounded up to 2MB, advised as huge page (if linux)
+			// Prefault -> pages are touched at creation, (not in parsing)
+			static const int HugePage = 1;
+			static const int Prefault = 2;
+			static const uint64_t hugePageSize = 2 * 1024 * 1024;
+
+			Block(uint64_t cap, int mode = 0)
 				: next(nullptr), capacity(cap), offset(0) {
+#ifndef _WIN32
+				if (mode & HugePage) {
+					const uint64_t len = (cap + hugePageSize - 1) / hugePageSize * hugePageSize;
+					void* ptr = mmap(nullptr, len + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+					if (ptr != MAP_FAILED) {
+						// over mapped for alignment, the rest is unmapped.
+						uint8_t* start = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(ptr) + hugePageSize - 1) & ~uintptr_t(hugePageSize - 1));
+						const uint64_t front = start - static_cast<uint8_t*>(ptr);
+						if (front > 0) {
+							munmap(ptr, front);
+						}
+						munmap(start + len, hugePageSize - front);
+#ifdef MADV_HUGEPAGE
+						madvise(start, len, MADV_HUGEPAGE);
+#endif
+						data = start;
+						capacity = len;
+						mapped = true;
+						if (mode & Prefault) {
+							Touch();
+						}
+						return;
+					}
+				}
+#endif
 				//data = (uint8_t*)mi_malloc(sizeof(uint8_t) * capacity); // 
 				data = new (std::nothrow) uint8_t[capacity];
+				if (data && (mode & Prefault)) {
+					Touch();
+				}
+			}
+
+			// page faults now.
+			void Touch() {
+				for (uint64_t i = 0; i < capacity; i += 4096) {
+					data[i] = 0;
+				}
 			}
 
 			~Block() {
+#ifndef _WIN32
+				if (mapped) {
+					munmap(data, capacity);
+					data = nullptr;
+					return;
+				}
+#endif
 				delete[] data;
 				data = nullptr;
 			//	mi_free(data);
@@ -617,6 +829,40 @@ namespace claujson {
 		BlockManager<Block> blockManager[2];
 		std::vector<Block*> startBlockVec[2];
 		std::vector<Block*> lastBlockVec[2];
+		KeyTable* keys = nullptr; // nullptr -> no key interning.
+		bool shape_share = false;
+		bool lazy = false; // true only in parsing, (input is kept in this Arena)
+		bool zero_copy = false; // also.
+		const char* input = nullptr; // kept input, strings can point to it.
+		uint64_t input_len = 0;
+
+		// free lists of size classes (memory from deallocate), 16 bytes step until 1KB, then 2^n until 64KB.
+		static const uint64_t unitSize = 16; // allocations are aligned and rounded up to unitSize.
+		static const uint64_t stepFreeSize = 1024;
+		static const uint64_t maxFreeSize = 64 * 1024;
+		static const int freeClassNum = 64 + 6;
+		struct FreeNode {
+			FreeNode* next;
+			uint64_t size;
+		};
+		FreeNode* free_list[freeClassNum] = {};
+		FreeNode* free_tail[freeClassNum] = {};
+		uint64_t free_num = 0; // number of nodes in free lists.
+		uint64_t free_bytes = 0;
+		uint64_t oversize_num = 0;
+		std::atomic<uint64_t> regrow_num{ 0 }; // counted at now_pool, Vector2 of other threads can grow.
+		int page_mode = 0; // Block::HugePage, Block::Prefault
+
+		// Arena of one thread, for concurrent mutation of a Document. (pushed lock-free, removed at MergeShards)
+		struct Shard {
+			std::thread::id owner;
+			Arena* arena;
+			Shard* next;
+		};
+		std::atomic<Shard*> shards{ nullptr };
+		static std::atomic<uint64_t> shard_epoch_counter;
+		uint64_t shard_epoch = shard_epoch_counter.fetch_add(1, std::memory_order_relaxed); // new at MergeShards, unique for all Arenas.
+		uint64_t retain_limit = 0; // max bytes of blocks kept in BlockManager after Reset or Clear, 0 -> bytes of blocks in use before.
 
 	private:
 		void RemoveBlocks(int no) {
@@ -657,7 +903,7 @@ namespace claujson {
 					blockManager[no].last_block->next = nullptr;
 				}
 
-				head[no] = blockManager[no].Get(defaultBlockSize);
+				head[no] = blockManager[no].Get(defaultBlockSize, page_mode);
 				rear[no] = head[no];
 			}
 			else {
@@ -665,6 +911,92 @@ namespace claujson {
 			}
 		}
 
+		void ClearFreeList() {
+			for (int i = 0; i < freeClassNum; ++i) {
+				free_list[i] = nullptr;
+				free_tail[i] = nullptr;
+			}
+			free_num = 0;
+			free_bytes = 0;
+		}
+
+		static uint64_t RoundUp(uint64_t x) {
+			return (x + unitSize - 1) & ~(unitSize - 1);
+		}
+
+		static uint8_t* RoundUp(uint8_t* p) {
+			return reinterpret_cast<uint8_t*>(RoundUp(reinterpret_cast<uintptr_t>(p)));
+		}
+
+		// class of free list for allocation, (0 < bytes <= maxFreeSize)
+		static int CeilClass(uint64_t bytes) {
+			if (bytes <= stepFreeSize) {
+				return static_cast<int>((bytes - 1) / unitSize);
+			}
+			int c = 64;
+			for (uint64_t x = 2 * stepFreeSize; x < bytes; x <<= 1) {
+				++c;
+			}
+			return c;
+		}
+
+		// class of free list for freed memory, (bytes >= unitSize, multiple of unitSize)
+		static int FloorClass(uint64_t bytes) {
+			if (bytes <= stepFreeSize) {
+				return static_cast<int>(bytes / unitSize) - 1;
+			}
+			int c = 63;
+			for (uint64_t x = 2 * stepFreeSize; x <= bytes && c + 1 < freeClassNum; x <<= 1) {
+				++c;
+			}
+			return c;
+		}
+
+		// if [begin, end) is the last allocation of head block, then roll back to begin.
+		bool RollBack(uint8_t* begin, uint8_t* end) {
+			end = RoundUp(end);
+			for (int no = 0; no < 2; ++no) {
+				Block* block = now_pool->head[no];
+				if (block && end == block->data + block->offset) {
+					block->offset = RoundUp(begin) - block->data;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// [begin, end) -> free list, end of allocation is rounded up to unitSize.
+		void Recycle(uint8_t* begin, uint8_t* end) {
+			begin = RoundUp(begin);
+			end = RoundUp(end);
+			if (begin >= end) {
+				return;
+			}
+			const int i = FloorClass(static_cast<uint64_t>(end - begin));
+			Arena* root = now_pool;
+
+			FreeNode* node = reinterpret_cast<FreeNode*>(begin);
+			node->size = static_cast<uint64_t>(end - begin);
+			node->next = root->free_list[i];
+			if (!root->free_list[i]) {
+				root->free_tail[i] = node;
+			}
+			root->free_list[i] = node;
+			root->free_num++;
+			root->free_bytes += node->size;
+		}
+
+		uint64_t RetainLimit(int no) const {
+			if (retain_limit) {
+				return retain_limit;
+			}
+			uint64_t bytes = 0;
+			for (const Block* block = head[no]; block; block = block->next) {
+				bytes += block->capacity;
+			}
+			return bytes;
+		}
+
 		// link_from -> Reset -> DivideBlock -> link_from...
 		void Reset(int no) {
 			if (lastBlockVec[no].empty()) {
@@ -685,7 +1017,7 @@ namespace claujson {
 				blockManager[no].last_block->next = nullptr;
 			}
 
-			head[no] = blockManager[no].Get(defaultBlockSize);
+			head[no] = blockManager[no].Get(defaultBlockSize, page_mode);
 			rear[no] = head[no];
 		}
 
@@ -714,8 +1046,19 @@ namespace claujson {
 			RemoveBlocks(1);
 		}
 		void Clear() {
+			MergeShards();
+			const uint64_t limit[2] = { RetainLimit(0), RetainLimit(1) };
 			Clear(0);
 			Clear(1);
+			blockManager[0].Trim(limit[0]);
+			blockManager[1].Trim(limit[1]);
+			if (keys) {
+				keys->clear();
+			}
+			ClearFreeList();
+			SetInput(nullptr, 0);
+			oversize_num = 0;
+			regrow_num = 0;
 			now_pool = this;
 			// chk! memory leak.-fix
 			while (next) {
@@ -727,8 +1070,19 @@ namespace claujson {
 			next = nullptr;
 		}
 		void Reset() {
+			MergeShards();
+			const uint64_t limit[2] = { RetainLimit(0), RetainLimit(1) };
 			Reset(0);
 			Reset(1);
+			blockManager[0].Trim(limit[0]);
+			blockManager[1].Trim(limit[1]);
+			if (keys) {
+				keys->clear();
+			}
+			ClearFreeList();
+			SetInput(nullptr, 0);
+			oversize_num = 0;
+			regrow_num = 0;
 			//now_pool = this;
 			// chk! memory leak.-fix
 			while (next) {
@@ -772,10 +1126,32 @@ namespace claujson {
 		Arena(const Arena&) = delete;
 		Arena& operator=(const Arena&) = delete;
 
-		static int64_t counter;
+		static std::atomic<int64_t> counter; // shards can allocate at the same time.
 	public:
 		template <class T>
 		T* allocate(uint64_t size, uint64_t align = alignof(T)) {
+			if (now_pool->shards.load(std::memory_order_relaxed)) { // -> shard of calling thread.
+				Arena* shard = now_pool->GetShard();
+				if (shard && shard != this) {
+					return shard->allocate<T>(size, align);
+				}
+			}
+			// reuse of deallocated memory.
+			size = RoundUp(size == 0 ? 1 : size);
+			if (now_pool->free_num && size <= maxFreeSize) {
+				Arena* root = now_pool;
+				const int i = CeilClass(size);
+				FreeNode* node = root->free_list[i];
+				if (node && reinterpret_cast<uintptr_t>(node) % alignof(T) == 0) {
+					root->free_list[i] = node->next;
+					if (!node->next) {
+						root->free_tail[i] = nullptr;
+					}
+					root->free_num--;
+					root->free_bytes -= node->size;
+					return reinterpret_cast<T*>(node);
+				}
+			}
 			{
 				int no = 0;
 				if (size + 64 >= defaultBlockSize) {
@@ -790,7 +1166,7 @@ namespace claujson {
 						void* ptr = block->data + block->offset;
 						void* aligned_ptr = ptr;
 						
-						if (std::align(alignof(T), size, aligned_ptr, remain)) {
+						if (std::align(alignof(T) > unitSize ? alignof(T) : unitSize, size, aligned_ptr, remain)) {
 							size_t aligned_offset = static_cast<uint8_t*>(aligned_ptr) - block->data;
 
 							block->offset = aligned_offset + size;
@@ -810,19 +1186,20 @@ namespace claujson {
 			if (newCap == size + 64) {
 				no = 1;
 			}
-			Block* newBlock = blockManager[no].Get(newCap); // new (std::nothrow) Block(newCap);
+			Block* newBlock = blockManager[no].Get(newCap, page_mode); // new (std::nothrow) Block(newCap);
 			if (!newBlock) {
 				return nullptr;
 			}
 			if (newCap == size + 64) { // chk over size?
 				counter++;
+				now_pool->oversize_num++;
 			}
 
 			uint64_t remain = newBlock->capacity - newBlock->offset;
 			void* ptr = newBlock->data + newBlock->offset;
 			void* aligned_ptr = ptr;
 
-			if (std::align(alignof(T), size, aligned_ptr, remain)) {
+			if (std::align(alignof(T) > unitSize ? alignof(T) : unitSize, size, aligned_ptr, remain)) {
 				uint64_t aligned_offset = static_cast<uint8_t*>(aligned_ptr) - newBlock->data;
 
 				newBlock->offset = aligned_offset + size;
@@ -837,26 +1214,40 @@ namespace claujson {
 			return nullptr;
 		}
 
-		// expand
+		// memory allocated from this Arena (or linked Arenas) -> roll back if last, else free list. (no destructor call)
 		template <class T>
-		void deallocate(T* ptr, uint64_t len) {		
-
-
-			return;
-
-			//return;
-			
-			// chk !
-			Block* block = now_pool->head[0];
-
-			while (block) {
-				if ((uint8_t*)(ptr) + sizeof(T) * len == (uint8_t*)(block->data) + block->offset) {
-					block->offset = (uint8_t*)ptr - (uint8_t*)block->data;
-						//std::cout << "real_deallocated\n"; //
+		void deallocate(T* ptr, uint64_t len) {
+			if (!ptr || len == 0) {
+				return;
+			}
+			if (now_pool->shards.load(std::memory_order_relaxed)) { // -> free list of shard of calling thread.
+				Arena* shard = now_pool->GetShard();
+				if (shard && shard != this) {
+					shard->deallocate<T>(ptr, len);
 					return;
 				}
+			}
+			uint8_t* begin = reinterpret_cast<uint8_t*>(ptr);
+			uint8_t* end = begin + sizeof(T) * len;
+			if (!RollBack(begin, end)) {
+				Recycle(begin, end);
+			}
+		}
 
-				block = block->next;
+		// buffer of String, (str[sz] == '\0') not if it is in kept input. (interned key is not given, String has SHARED_BUFFER)
+		void deallocate_str(char* str, uint64_t sz) {
+			const Arena* root = now_pool;
+			if (!str || (root->input && str >= root->input && str < root->input + root->input_len)) {
+				return;
+			}
+			deallocate<char>(str, sz + 1);
+		}
+
+		// (ptr, len) -> (ptr, new_len), the rest is deallocated.
+		template <class T>
+		void shrink(T* ptr, uint64_t len, uint64_t new_len) {
+			if (new_len < len) {
+				deallocate<T>(ptr + new_len, len - new_len);
 			}
 		}
 
@@ -866,12 +1257,238 @@ namespace claujson {
 			return new (mem) T(std::forward<Args>(args)...);
 		}
 
+		// key interning, keys of parsed objects (size >= 11) share one copy. off by default.
+		void EnableKeyIntern(bool on) {
+			if (on && !keys) {
+				keys = new (std::nothrow) KeyTable();
+			}
+			else if (!on && keys) {
+				delete keys;
+				keys = nullptr;
+			}
+		}
+
+		bool IsKeyIntern() const {
+			return now_pool->keys != nullptr;
+		}
+
+		// objects of same layout (ex) records of array) share buffers of long keys, in parsing. off by default.
+		void EnableShapeShare(bool on) {
+			shape_share = on;
+		}
+
+		bool IsShapeShare() const {
+			return now_pool->shape_share;
+		}
+
+		// primitive values point to input in parsing, set by parser.
+		void EnableLazy(bool on) {
+			lazy = on;
+		}
+
+		bool IsLazy() const {
+			return now_pool->lazy;
+		}
+
+		// strings without escape point to input in parsing, set by parser.
+		void EnableZeroCopy(bool on) {
+			zero_copy = on;
+		}
+
+		bool IsZeroCopy() const {
+			return now_pool->zero_copy;
+		}
+
+		// Vector2 with data moved to bigger memory. (not at reserve of empty Vector2)
+		void CountRegrow() {
+			now_pool->regrow_num.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// walks lists of blocks, (not for every allocation) counters of free lists and oversize are kept always.
+		ArenaStats GetStats() const {
+			ArenaStats stats;
+			const Arena* root = now_pool;
+			for (int no = 0; no < 2; ++no) {
+				for (const Block* block = root->head[no]; block; block = block->next) {
+					stats.block_num[no]++;
+					stats.reserved[no] += block->capacity;
+					stats.used[no] += block->offset;
+				}
+				root->blockManager[no].Stats(stats.recycled_block_num[no], stats.recycled[no]);
+			}
+			stats.free_num = root->free_num;
+			stats.free_bytes = root->free_bytes;
+			stats.oversize_num = root->oversize_num;
+			stats.regrow_num = root->regrow_num.load(std::memory_order_relaxed);
+			for (const Arena* x = root; x; x = x->next) {
+				stats.arena_num++;
+			}
+			// shards, (not exact if other threads use them now)
+			for (const Shard* x = root->shards.load(std::memory_order_acquire); x; x = x->next) {
+				const ArenaStats shard = x->arena->GetStats();
+				for (int no = 0; no < 2; ++no) {
+					stats.block_num[no] += shard.block_num[no];
+					stats.reserved[no] += shard.reserved[no];
+					stats.used[no] += shard.used[no];
+					stats.recycled_block_num[no] += shard.recycled_block_num[no];
+					stats.recycled[no] += shard.recycled[no];
+				}
+				stats.free_num += shard.free_num;
+				stats.free_bytes += shard.free_bytes;
+				stats.oversize_num += shard.oversize_num;
+				stats.regrow_num += shard.regrow_num;
+				stats.arena_num += shard.arena_num;
+			}
+			return stats;
+		}
+
+		// new blocks are huge pages (2MB, linux) and/or prefaulted, Block::HugePage | Block::Prefault. 0 by default.
+		void SetPageMode(int mode) {
+			page_mode = mode;
+		}
+
+		int GetPageMode() const {
+			return page_mode;
+		}
+
+		// Arena (shard) of calling thread, created at first call. while shards exist, allocate and deallocate of this Arena
+		// go to shard of calling thread, so threads can add values to disjoint subtrees of one Document at the same time.
+		Arena* GetShard() {
+			// last shard of this thread, valid while root and its epoch are same. (no walk of the list)
+			struct ShardCache {
+				const Arena* root = nullptr;
+				uint64_t epoch = 0;
+				Arena* shard = nullptr;
+			};
+			static thread_local ShardCache cache;
+
+			Arena* root = now_pool;
+			if (cache.root == root && cache.epoch == root->shard_epoch) {
+				return cache.shard;
+			}
+
+			const std::thread::id id = std::this_thread::get_id();
+			for (Shard* x = root->shards.load(std::memory_order_acquire); x; x = x->next) {
+				if (x->owner == id) {
+					cache = { root, root->shard_epoch, x->arena };
+					return x->arena;
+				}
+			}
+
+			Shard* shard = new (std::nothrow) Shard{ id, nullptr, nullptr };
+			if (!shard) {
+				return nullptr;
+			}
+			shard->arena = new (std::nothrow) Arena(root->defaultBlockSize);
+			if (!shard->arena) {
+				delete shard;
+				return nullptr;
+			}
+			shard->arena->SetPageMode(root->page_mode);
+
+			Shard* head = root->shards.load(std::memory_order_relaxed);
+			do {
+				shard->next = head;
+			} while (!root->shards.compare_exchange_weak(head, shard, std::memory_order_release, std::memory_order_relaxed));
+			cache = { root, root->shard_epoch, shard->arena };
+			return shard->arena;
+		}
+
+		// shards -> linked to this, like Arenas of parsing. call when no thread uses shards, (next GetShard makes new one)
+		void MergeShards() {
+			shard_epoch = shard_epoch_counter.fetch_add(1, std::memory_order_relaxed); // caches of threads are old.
+			Shard* x = shards.exchange(nullptr, std::memory_order_acquire);
+			while (x) {
+				Shard* next = x->next;
+				link_from(x->arena);
+				delete x;
+				x = next;
+			}
+		}
+
+		// recycled blocks of each list are kept until bytes, others are deleted at Reset or Clear.
+		// 0 (default) -> as much as blocks in use before Reset or Clear. (memory of bigger document before is freed)
+		void SetRetainLimit(uint64_t bytes) {
+			retain_limit = bytes;
+		}
+
+		// input kept in this Arena, (for lazy or zero copy) until Reset or Clear.
+		void SetInput(const char* str, uint64_t len) {
+			input = str;
+			input_len = len;
+		}
+
+		const char* GetInput() const {
+			return now_pool->input;
+		}
+
+		uint64_t GetInputSize() const {
+			return now_pool->input_len;
+		}
+
+		// shared copy of str, (nullptr if key interning is off or fail)
+		char* intern(const char* str, uint32_t sz) {
+			KeyTable* table = now_pool->keys;
+			if (!table) {
+				return nullptr;
+			}
+			const uint32_t hash = KeyTable::Hash(str, sz);
+			char* result = table->find(str, sz, hash);
+			if (result) {
+				return result;
+			}
+			result = allocate<char>(sizeof(char) * (static_cast<uint64_t>(sz) + 1));
+			if (!result) {
+				return nullptr;
+			}
+			memcpy(result, str, sz);
+			result[sz] = '\0';
+			table->insert({ result, sz, hash });
+			return result;
+		}
+
+		// str is allocated in this Arena, (str[sz] == '\0') if not in table, then str is the shared copy.
+		char* intern_in_place(char* str, uint32_t sz) {
+			KeyTable* table = now_pool->keys;
+			if (!table) {
+				return nullptr;
+			}
+			const uint32_t hash = KeyTable::Hash(str, sz);
+			char* result = table->find(str, sz, hash);
+			if (result) {
+				return result;
+			}
+			table->insert({ str, sz, hash });
+			return str;
+		}
+
+		// shared copy of str in table, (nullptr if none) only reads, for many threads.
+		char* find_key(const char* str, uint32_t sz) const {
+			const KeyTable* table = now_pool->keys;
+			return table ? table->find(str, sz, KeyTable::Hash(str, sz)) : nullptr;
+		}
+
+		// table of other -> table of this, keys already in this are not added. (-> copies) then table of other is empty.
+		void merge_keys(Arena* other, std::vector<KeyTable::Entry>* copies) {
+			KeyTable* table = now_pool->keys;
+			KeyTable* from = other->now_pool->keys;
+			if (table && from) {
+				table->merge(*from, copies);
+				from->clear();
+			}
+		}
+
 	public:
 		~Arena() {
+			if (keys) {
+				delete keys;
+				keys = nullptr;
+			}
 			if (this != now_pool) {
 				return;
 			}
-			
+
+			MergeShards();
 			RemoveBlocks();
 
 			while (next) {
@@ -896,27 +1513,49 @@ namespace claujson {
 					this->rear[i]->next = other->head[i];
 					this->rear[i] = other->rear[i];
 				}
+				// other has linked Arenas, (pairwise link) then its segments follow.
+				this->startBlockVec[i].insert(this->startBlockVec[i].end(), other->startBlockVec[i].begin(), other->startBlockVec[i].end());
+				this->lastBlockVec[i].insert(this->lastBlockVec[i].end(), other->lastBlockVec[i].begin(), other->lastBlockVec[i].end());
+				other->startBlockVec[i].clear();
+				other->lastBlockVec[i].clear();
 			}
 
 			for (int no = 0; no < 2; ++no) {
-				if (this->blockManager[no].last_block) {
-					this->blockManager[no].last_block->next = other->blockManager[no].start_block;
-				}
-				else {
-					this->blockManager[no].start_block = other->blockManager[no].start_block;
-				}
-				if (!this->blockManager[no].start_block) {
-					this->blockManager[no].start_block = other->blockManager[no].start_block;
-				}
-				this->blockManager[no].last_block = other->blockManager[no].last_block;
+				this->blockManager[no].Merge(other->blockManager[no]);
+			}
 
-				other->blockManager[no].start_block = nullptr;
-				other->blockManager[no].last_block = nullptr;
+			if (this->keys && other->keys) {
+				this->keys->merge(*other->keys);
+			}
+			if (other->keys) {
+				delete other->keys;
+				other->keys = nullptr;
 			}
 
-			other->now_pool = this->now_pool;
-			
-			other->next = this->next;
+			for (int i = 0; i < freeClassNum; ++i) {
+				if (!other->free_list[i]) {
+					continue;
+				}
+				other->free_tail[i]->next = this->free_list[i];
+				if (!this->free_list[i]) {
+					this->free_tail[i] = other->free_tail[i];
+				}
+				this->free_list[i] = other->free_list[i];
+			}
+			this->free_num += other->free_num;
+			this->free_bytes += other->free_bytes;
+			this->oversize_num += other->oversize_num;
+			other->oversize_num = 0;
+			this->regrow_num += other->regrow_num.exchange(0, std::memory_order_relaxed);
+			other->ClearFreeList();
+
+			// other and Arenas linked to it.
+			Arena* tail = other;
+			for (Arena* x = other; x; x = x->next) {
+				x->now_pool = this->now_pool;
+				tail = x;
+			}
+			tail->next = this->next;
 			this->next = other;
 		
 			for (int i = 0; i < 2; ++i) {
@@ -963,7 +1602,10 @@ namespace claujson {
 			m_size = sz;
 			m_capacity = capacity; 
 			// todo - sz <= capacity!
-			if (pool) {
+			if (m_capacity == 0) {
+				// no alloc.
+			}
+			else if (pool) {
 				m_arr = (T*)pool->allocate<T>(sizeof(T) * m_capacity, alignof(T));
 
 				//for (uint64_t i = 0; i < m_size; ++i) {
@@ -1058,7 +1700,7 @@ namespace claujson {
 			std::swap(pool, other.pool);
 		}
 	public:
-		Arena* get_pool() { return pool; }
+		Arena* get_pool() const { return pool; }
 
 	public:
 
@@ -1150,6 +1792,23 @@ namespace claujson {
 				expand(sz);
 			}
 		}
+		// size += n with exact capacity, new items are not constructed. (caller constructs them, ex) in parallel)
+		T* extend(uint64_t n) {
+			reserve(m_size + n);
+			T* result = m_arr + m_size;
+			m_size += n;
+			return result;
+		}
+		// capacity -> size, the rest is given back to pool. (only with pool)
+		void shrink_to_fit() {
+			if (pool && m_capacity > m_size) {
+				pool->shrink<T>(m_arr, m_capacity, m_size);
+				m_capacity = m_size;
+				if (0 == m_size) {
+					m_arr = nullptr;
+				}
+			}
+		}
 		bool empty() const { return 0 == m_size; }
 		T* begin() { return m_arr; }
 		T* end() { return m_arr + m_size; }
@@ -1162,7 +1821,7 @@ namespace claujson {
 		uint64_t capacity() const { return m_capacity; }
 
 		void resize(uint64_t sz) {
-			if (sz < m_capacity) {
+			if (sz <= m_capacity) {
 				m_size = sz;
 				return;
 			}
@@ -1172,6 +1831,9 @@ namespace claujson {
 	private:
 		void expand(uint64_t new_capacity) {
 			if (pool) {
+				if (m_size > 0) {
+					pool->CountRegrow();
+				}
 				T* temp = (T*)pool->allocate<T>(sizeof(T) * new_capacity);
 				for (uint64_t i = 0; i < m_size; ++i) {
 					//new (temp + i) T();
@@ -1,10 +1,47 @@
 ﻿#include "claujson.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define CLAUJSON_SSE2_KEY
+#endif
+
+// AVX2 path is compiled with target attribute, and chosen at runtime. (not needs -mavx2)
+#if defined(CLAUJSON_SSE2_KEY) && defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define CLAUJSON_AVX2_KEY
+#endif
+
 namespace claujson {
 	extern Log log;
 
 	_Value Object::data_null{ nullptr, false }; // valid is false..
 	const uint64_t Object::npos = -1; // 
+	const uint64_t Object::index_threshold = 64;
+
+#ifdef CLAUJSON_AVX2_KEY
+	static bool HasAVX2() {
+		__builtin_cpu_init(); // before static constructors are done.
+		return __builtin_cpu_supports("avx2");
+	}
+	static const bool cpu_avx2 = HasAVX2();
+#endif
+
+	// FNV-1a
+	static inline uint64_t HashKey(const _Value& key) {
+		if (!key.is_str()) {
+			return 0;
+		}
+		const String& str = key.get_string();
+		const char* x = str.data();
+		const uint64_t len = str.size();
+
+		uint64_t h = 14695981039346656037ULL;
+		for (uint64_t i = 0; i < len; ++i) {
+			h ^= static_cast<uint8_t>(x[i]);
+			h *= 1099511628211ULL;
+		}
+		return h ^ (h >> 32);
+	}
 
 	class CompKey {
 	private:
@@ -67,7 +104,7 @@ namespace claujson {
 		if (pool) {
 			obj = (Object*)pool->allocate<Object>(sizeof(Object), alignof(Object)); // new (std::nothrow) Object();
 			new (obj) Object();
-			obj->obj_data = my_vector<Pair<_Value, _Value>>(pool, 0, 2);
+			obj->obj_data = my_vector<Pair<_Value, _Value>>(pool, 0, 0); // allocated at reserve_data_list or first push_back.
 		}
 		else {
 			obj = new (std::nothrow) Object();
@@ -85,7 +122,7 @@ namespace claujson {
 		if (pool) {
 			obj = (Object*)pool->allocate<Object>(sizeof(Object), alignof(Object)); // new (std::nothrow) Object();
 			new (obj) Object();
-			obj->obj_data = my_vector<Pair<_Value, _Value>>(pool, 0, 2);
+			obj->obj_data = my_vector<Pair<_Value, _Value>>(pool, 0, 0); // allocated at reserve_data_list or first push_back.
 		}
 		else {
 			obj = new (std::nothrow) Object();
@@ -102,7 +139,7 @@ namespace claujson {
 	Object::Object() {}
 
 	Object::~Object() {
-		//
+		drop_index();
 	}
 
 	void Object::null_parent() {
@@ -120,6 +157,9 @@ namespace claujson {
 	uint64_t Object::get_data_size() const {
 		return obj_data.size();
 	}
+	uint64_t Object::get_data_capacity() const {
+		return obj_data.capacity();
+	}
 
 	_Value& Object::get_value_list(uint64_t idx) {
 		return obj_data[idx].second;
@@ -144,6 +184,7 @@ namespace claujson {
 	}
 
 	void Object::clear(uint64_t idx) {
+		drop_index();
 		obj_data[idx].second.clear(false);
 		obj_data[idx].first.clear(false);
 	}
@@ -154,6 +195,7 @@ namespace claujson {
 	}
 
 	void Object::clear() {
+		drop_index();
 		obj_data.clear();
 	}
 
@@ -177,6 +219,9 @@ namespace claujson {
 	void Object::reserve_data_list(uint64_t len) {
 		obj_data.reserve(len);
 	}
+	void Object::shrink_data_list() {
+		obj_data.shrink_to_fit();
+	}
 
 
 	void Object::set_parent(StructuredPtr p) {
@@ -185,12 +230,214 @@ namespace claujson {
 	}
 
 
+	void Object::build_index() {
+		const uint64_t len = get_data_size();
+		uint64_t capacity = 16;
+		while (capacity < 2 * len) { // load factor <= 0.5
+			capacity <<= 1;
+		}
+
+		if (index_capacity < capacity) {
+			drop_index();
+
+			Arena* pool = obj_data.get_pool();
+			if (pool) {
+				index = (uint32_t*)pool->allocate<uint32_t>(sizeof(uint32_t) * capacity);
+			}
+			else {
+				index = new (std::nothrow) uint32_t[capacity];
+			}
+			if (index == nullptr) {
+				log << warn << "new error";
+				return;
+			}
+			index_capacity = capacity;
+		}
+
+		const uint64_t mask = index_capacity - 1;
+		memset(index, 0, sizeof(uint32_t) * index_capacity);
+		for (uint64_t i = 0; i < len; ++i) {
+			uint64_t slot = HashKey(obj_data[i].first) & mask;
+			while (index[slot] != 0) {
+				slot = (slot + 1) & mask;
+			}
+			index[slot] = static_cast<uint32_t>(i + 1);
+		}
+	}
+
+	void Object::index_insert(uint64_t idx) {
+		const uint64_t mask = index_capacity - 1;
+		uint64_t slot = HashKey(obj_data[idx].first) & mask;
+
+		while (index[slot] != 0) {
+			slot = (slot + 1) & mask;
+		}
+		index[slot] = static_cast<uint32_t>(idx + 1);
+	}
+
+	void Object::index_remove(uint64_t idx) {
+		const uint64_t mask = index_capacity - 1;
+		uint64_t slot = HashKey(obj_data[idx].first) & mask;
+
+		while (index[slot] != idx + 1) {
+			if (index[slot] == 0) { // chk
+				return;
+			}
+			slot = (slot + 1) & mask;
+		}
+
+		// backward shift, no tombstone.
+		index[slot] = 0;
+		for (uint64_t j = (slot + 1) & mask; index[j] != 0; j = (j + 1) & mask) {
+			const uint64_t home = HashKey(obj_data[index[j] - 1].first) & mask;
+			const bool stay = slot <= j ? (slot < home && home <= j) : (slot < home || home <= j);
+
+			if (!stay) {
+				index[slot] = index[j];
+				index[j] = 0;
+				slot = j;
+			}
+		}
+	}
+
+	void Object::drop_index() {
+		if (index && !obj_data.get_pool()) {
+			delete[] index;
+		}
+		else if (index) {
+			obj_data.get_pool()->deallocate<uint32_t>(index, index_capacity);
+		}
+		index = nullptr;
+		index_capacity = 0;
+	}
+
+#ifdef CLAUJSON_AVX2_KEY
+	__attribute__((target("avx2")))
+	uint64_t Object::find_short_key_avx2(const void* key_image, uint32_t mask) const {
+		const __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key_image));
+		const __m256i x = _mm256_broadcastsi128_si256(x1);
+		const uint64_t len = get_data_size();
+		uint64_t i = 0;
+
+		for (; i + 1 < len; i += 2) {
+			const _Value& a = obj_data[i].first;
+			const _Value& b = obj_data[i + 1].first;
+			const bool a_str = a._type == _ValueType::STRING || a._type == _ValueType::SHORT_STRING;
+			const bool b_str = b._type == _ValueType::STRING || b._type == _ValueType::SHORT_STRING;
+			if (!a_str || !b_str) { // one by one.
+				if (a_str && (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(a._str_val))))) & mask) == mask) {
+					return i;
+				}
+				if (b_str && (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(b._str_val))))) & mask) == mask) {
+					return i + 1;
+				}
+				continue;
+			}
+			// [0, 16) : a, [16, 32) : b.
+			const __m256i y = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a._str_val))),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(b._str_val)), 1);
+			const uint32_t eq = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+			if ((eq & mask) == mask) {
+				return i;
+			}
+			if (((eq >> 16) & mask) == mask) {
+				return i + 1;
+			}
+		}
+		if (i < len) {
+			const _Value& a = obj_data[i].first;
+			if ((a._type == _ValueType::STRING || a._type == _ValueType::SHORT_STRING)
+				&& (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(a._str_val))))) & mask) == mask) {
+				return i;
+			}
+		}
+		return npos;
+	}
+#endif
+
 	uint64_t Object::find(const _Value& key) const {
 		if (!is_object() || !key.is_str()) { // } || !is_valid()) {
 			return npos;
 		}
 
 		uint64_t len = get_data_size();
+
+		if (index) {
+			const uint64_t mask = index_capacity - 1;
+			uint64_t result = npos;
+
+			for (uint64_t slot = HashKey(key) & mask; index[slot] != 0; slot = (slot + 1) & mask) {
+				const uint64_t i = index[slot] - 1;
+				if (i < result && get_key_list(i) == key) { // same keys -> first one.
+					result = i;
+				}
+			}
+			return result;
+		}
+
+		const String& key_str = *key._str_val; // _Value::_type is STRING, String::type is STRING or SHORT_STRING.
+
+		if (key_str.type == _ValueType::SHORT_STRING && key_str.buf_sz < CLAUJSON_STRING_BUF_SIZE) {
+			// key image : first 16 bytes of String, buf[11] + buf_sz + type.
+			// compare chars in [0, buf_sz) + buf_sz + type, (not used chars are not initialized.)
+			const uint32_t mask = ((1u << key_str.buf_sz) - 1) | 0xF800u;
+#ifdef CLAUJSON_AVX2_KEY
+			if (cpu_avx2 && len >= 16) { // small object -> no call, SSE2 loop below.
+				return find_short_key_avx2(key._str_val, mask);
+			}
+#endif
+#ifdef CLAUJSON_SSE2_KEY
+			const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key._str_val));
+
+			for (uint64_t i = 0; i < len; ++i) {
+				const _Value& k = obj_data[i].first;
+				if (k._type != _ValueType::STRING && k._type != _ValueType::SHORT_STRING) {
+					continue;
+				}
+				const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(k._str_val));
+				if ((static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) & mask) == mask) {
+					return i;
+				}
+			}
+#else
+			uint8_t mask_bytes[16];
+			for (int i = 0; i < 16; ++i) {
+				mask_bytes[i] = (mask & (1u << i)) ? 0xFF : 0;
+			}
+			uint64_t x[2], m[2];
+			memcpy(x, key._str_val, 16);
+			memcpy(m, mask_bytes, 16);
+
+			for (uint64_t i = 0; i < len; ++i) {
+				const _Value& k = obj_data[i].first;
+				if (k._type != _ValueType::STRING && k._type != _ValueType::SHORT_STRING) {
+					continue;
+				}
+				uint64_t y[2];
+				memcpy(y, k._str_val, 16);
+				if ((((x[0] ^ y[0]) & m[0]) | ((x[1] ^ y[1]) & m[1])) == 0) {
+					return i;
+				}
+			}
+#endif
+			return npos;
+		}
+
+		if (key_str.type == _ValueType::STRING) {
+			const uint64_t key_len = key_str.sz;
+			const char* key_data = key_str.str;
+
+			for (uint64_t i = 0; i < len; ++i) {
+				const _Value& k = obj_data[i].first;
+				if ((k._type == _ValueType::STRING || k._type == _ValueType::SHORT_STRING)
+					&& k._str_val->type == _ValueType::STRING && k._str_val->sz == key_len
+					&& (k._str_val->str == key_data || memcmp(k._str_val->str, key_data, key_len) == 0)) { // interned -> same pointer.
+					return i;
+				}
+			}
+			return npos;
+		}
+
 		for (uint64_t i = 0; i < len; ++i) {
 			if (get_key_list(i) == key) {
 				return i;
@@ -214,6 +461,36 @@ namespace claujson {
 		return get_value_list(idx);
 	}
 
+	uint64_t Object::find(const KeyHandle& key) const {
+		const uint64_t hint = key.hint;
+		if (hint < get_data_size()) { // same shape -> same idx.
+			const _Value& k = obj_data[hint].first;
+			const _Value& x = key.get();
+
+			if (k._type == _ValueType::STRING && x._type == _ValueType::STRING
+				&& k._str_val->type == x._str_val->type) {
+				const String& a = *k._str_val;
+				const String& b = *x._str_val;
+				if (a.type == _ValueType::SHORT_STRING) {
+					if (a.buf_sz == b.buf_sz && memcmp(a.buf, b.buf, a.buf_sz) == 0) {
+						return hint;
+					}
+				}
+				else if (a.type == _ValueType::STRING && a.sz == b.sz && (a.str == b.str || memcmp(a.str, b.str, a.sz) == 0)) {
+					return hint;
+				}
+			}
+			else if (k == x) {
+				return hint;
+			}
+		}
+		const uint64_t idx = find(key.get());
+		if (idx != npos) {
+			key.hint = idx;
+		}
+		return idx;
+	}
+
 	_Value& Object::operator[](const _Value& key) { // if not exist key, then nothing.
 		uint64_t idx = npos;
 		if ((idx = find(key)) == npos) {
@@ -231,6 +508,23 @@ namespace claujson {
 		return get_value_list(idx);
 	}
 
+	_Value& Object::operator[](const KeyHandle& key) {
+		uint64_t idx = npos;
+		if ((idx = find(key)) == npos) {
+			return data_null;
+		}
+
+		return get_value_list(idx);
+	}
+	const _Value& Object::operator[](const KeyHandle& key) const {
+		uint64_t idx = npos;
+		if ((idx = find(key)) == npos) {
+			return data_null;
+		}
+
+		return get_value_list(idx);
+	}
+
 	const StructuredPtr Object::get_parent() const {
 		int type = this->parent.right_type();
 		if (type == 1) {
@@ -252,8 +546,16 @@ namespace claujson {
 				return false;
 			}
 
+			if (index) {
+				index_remove(idx);
+			}
+
 			get_key_list(idx) = std::move(new_key.Get());
 
+			if (index) {
+				index_insert(idx);
+			}
+
 			return true;
 		}
 		return false;
@@ -265,8 +567,16 @@ namespace claujson {
 				return false;
 			}
 
+			if (index) {
+				index_remove(idx);
+			}
+
 			get_key_list(idx) = std::move(new_key.Get());
 
+			if (index) {
+				index_insert(idx);
+			}
+
 			return true;
 		}
 		return false;
@@ -284,6 +594,9 @@ namespace claujson {
 				x->set_parent(this);
 			}
 			obj_data.push_back({ std::move(key.Get()), std::move(val.Get()) });
+			if (index) {
+				drop_index(); // virtual object, key is not string.
+			}
 			return true;
 		}
 
@@ -303,6 +616,18 @@ namespace claujson {
 		}
 		obj_data.push_back({ std::move(key.Get()), std::move(val.Get()) });
 
+		if (index) {
+			if (2 * get_data_size() > index_capacity) {
+				build_index();
+			}
+			else {
+				index_insert(get_data_size() - 1);
+			}
+		}
+		else if (get_data_size() >= index_threshold && !is_virtual()) {
+			build_index();
+		}
+
 		return true;
 	}
 
@@ -322,6 +647,15 @@ namespace claujson {
 
 	void Object::erase(uint64_t idx, bool real) {
 
+		if (index && idx < get_data_size()) {
+			index_remove(idx);
+			for (uint64_t i = 0; i < index_capacity; ++i) { // items after idx are moved by one.
+				if (index[i] > idx + 1) {
+					--index[i];
+				}
+			}
+		}
+
 		if (real) {
 			clean(obj_data[idx].first);
 			clean(obj_data[idx].second);
@@ -330,17 +664,19 @@ namespace claujson {
 	}
 
 
-	void Object::MergeWith(Array* j, int start_offset) {
+	void Object::MergeWith(Array* j, int start_offset, bool update_parent) {
 		ERROR("Object::MergeWith Error");
 		return;
 	}
 
 
-	void Object::MergeWith(Object* j, int start_offset) {
+	void Object::MergeWith(Object* j, int start_offset, bool update_parent) {
 		auto* x = j;
 
+		drop_index();
+
 		uint64_t len = j->get_data_size();
-		for (uint64_t i = 0; i < len; ++i) {
+		for (uint64_t i = (update_parent || len == 0) ? 0 : len - 1; i < len; ++i) {
 			if (j->get_value_list(i).is_structured()) {
 				if (j->get_value_list(i).is_array()) {
 					j->get_value_list(i).as_array()->set_parent(this);
@@ -359,16 +695,18 @@ namespace claujson {
 			log << info << "test1";
 		}
 	}
-	void Object::MergeWith(PartialJson* j, int start_offset) {
+	void Object::MergeWith(PartialJson* j, int start_offset, bool update_parent) {
 
 		auto* x = j;
 
+		drop_index();
+
 		if (x->arr_vec.empty() == false) { // not object?
 			ERROR("partial json is not object");
 		}
 
 		uint64_t len = j->get_data_size();
-		for (uint64_t i = 0; i < len; ++i) {
+		for (uint64_t i = (update_parent || len == 0) ? 0 : len - 1; i < len; ++i) {
 			if (j->get_value_list(i).is_structured()) {
 				if (j->get_value_list(i).is_array()) {
 					j->get_value_list(i).as_array()->set_parent(this);
@@ -393,7 +731,7 @@ namespace claujson {
 	}
 
 	void Object::add_item_type(int64_t key_buf_idx, int64_t key_next_buf_idx, int64_t val_buf_idx, int64_t val_next_buf_idx,
-		char* buf, uint64_t key_token_idx, uint64_t val_token_idx, Arena* pool) {
+		char* buf, uint64_t key_token_idx, uint64_t val_token_idx, Arena* pool, const _Value* shape_key) {
 
 			{
 				_Value temp;// key
@@ -401,7 +739,7 @@ namespace claujson {
 
 				bool e = false;
 
-				claujson::Convert(pool, temp, key_buf_idx, key_next_buf_idx, true, buf, key_token_idx, e);
+				claujson::Convert(pool, temp, key_buf_idx, key_next_buf_idx, true, buf, key_token_idx, e, shape_key);
 
 				if (e) {
 					ERROR("Error in add_item_type");
@@ -438,7 +776,7 @@ namespace claujson {
 	}
 
 	void Object::add_user_type(int64_t key_buf_idx, int64_t key_next_buf_idx, char* buf,
-		_ValueType type, uint64_t key_token_idx, Arena* pool
+		_ValueType type, uint64_t key_token_idx, Arena* pool, const _Value* shape_key
 
 	) {
 
@@ -446,7 +784,7 @@ namespace claujson {
 			_Value temp;
 			bool e = false;
 
-			claujson::Convert(pool, temp, key_buf_idx, key_next_buf_idx, true, buf, key_token_idx, e);
+			claujson::Convert(pool, temp, key_buf_idx, key_next_buf_idx, true, buf, key_token_idx, e, shape_key);
 			if (e) {
 				ERROR("Error in add_user_type");
 			}
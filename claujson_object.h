@@ -7,9 +7,15 @@ namespace claujson {
 		my_vector<Pair<claujson::_Value, claujson::_Value>> obj_data;
 		Pointer parent;
 
+		// hash index for find, slot -> idx + 1 (0 : empty slot), linear probing. (in Arena if has_pool())
+		// built only on non-const paths, (end of object in parse, add_element, build_index) const find only reads it.
+		uint32_t* index = nullptr;
+		uint64_t index_capacity = 0; // power of 2.
+
 	public:
 		static _Value data_null; // valid is false..
 		static const uint64_t npos;
+		static const uint64_t index_threshold; // parse and add_element build hash index if size() >= index_threshold.
 	public:
 		using _ValueIterator = Pair<claujson::_Value, claujson::_Value>*; // my_vector<Pair<claujson::_Value, claujson::_Value>>::iterator;
 		using _ConstValueIterator = const Pair<claujson::_Value, claujson::_Value>*; // my_vector<Pair<claujson::_Value, claujson::_Value>>::const_iterator;
@@ -27,10 +33,19 @@ namespace claujson {
 		void set_parent(StructuredPtr);
 
 		uint64_t find(const _Value& key) const; // find without key`s converting ( \uxxxx )
+		// check key.hint first, then find(key.get()). (key is duplicated -> may not be first one.)
+		uint64_t find(const KeyHandle& key) const;
+
+		// build hash index now, allocates from Arena. (for objects changed by other functions, find is linear search without it)
+		void build_index();
+		bool has_index() const { return index != nullptr; }
 
 		_Value& operator[](const _Value& key); // if not exist key, then _Value <- is not valid.
 		const _Value& operator[](const _Value& key) const; // if not exist key, then _Value <- is not valid.
 
+		_Value& operator[](const KeyHandle& key);
+		const _Value& operator[](const KeyHandle& key) const;
+
 		_Value& operator[](uint64_t idx);
 
 		const _Value& operator[](uint64_t idx) const;
@@ -73,6 +88,7 @@ namespace claujson {
 		 bool is_array() const;
 
 		 uint64_t get_data_size() const;
+		 uint64_t get_data_capacity() const;
 
 		 _Value& get_value_list(uint64_t idx);
 	private:
@@ -102,6 +118,7 @@ namespace claujson {
 		_ConstValueIterator end() const;
 
 		 void reserve_data_list(uint64_t len);
+		 void shrink_data_list(); // capacity -> size.
 
 		 bool add_element(Value key, Value val);
 
@@ -113,18 +130,25 @@ namespace claujson {
 
 
 	private:
-		 void MergeWith(Array* j, int start_offset);
-		 void MergeWith(Object* j, int start_offset);
-		 void MergeWith(PartialJson* j, int start_offset);
+		 // short key image (16 bytes of String) in keys, two keys per step with AVX2. (only if cpu has it, CLAUJSON_AVX2_KEY)
+		 uint64_t find_short_key_avx2(const void* key_image, uint32_t mask) const;
+
+		 void index_insert(uint64_t idx);
+		 void index_remove(uint64_t idx); // before obj_data[idx] is changed.
+		 void drop_index();
+
+		 void MergeWith(Array* j, int start_offset, bool update_parent = true); // update_parent == false -> only parent of last item is updated.
+		 void MergeWith(Object* j, int start_offset, bool update_parent = true);
+		 void MergeWith(PartialJson* j, int start_offset, bool update_parent = true);
 
 		 void add_item_type(int64_t key_buf_idx, int64_t key_next_buf_idx, int64_t val_buf_idx, int64_t val_next_buf_idx,
-			char* buf, uint64_t key_token_idx, uint64_t val_token_idx, Arena* pool);
+			char* buf, uint64_t key_token_idx, uint64_t val_token_idx, Arena* pool, const _Value* shape_key = nullptr);
 
 		 void add_item_type(int64_t val_buf_idx, int64_t val_next_buf_idx,
 			char* buf, uint64_t val_token_idx);
 
 		 void add_user_type(int64_t key_buf_idx, int64_t key_next_buf_idx, char* buf,
-			_ValueType type, uint64_t key_token_idx, Arena* pool
+			_ValueType type, uint64_t key_token_idx, Arena* pool, const _Value* shape_key = nullptr
 
 		);
 
@@ -195,6 +195,9 @@ namespace claujson {
 					ERROR("partialJson is array or object.6");
 				}
 
+				if (obj_data.empty()) {
+					obj_data.reserve(item_num);
+				}
 				obj_data.push_back({ std::move(temp), std::move(temp2) });
 			}
 	}
@@ -217,6 +220,9 @@ namespace claujson {
 					ERROR("partialJson is array or object.5");
 				}
 
+				if (arr_vec.empty()) {
+					arr_vec.reserve(item_num);
+				}
 				arr_vec.push_back(std::move(temp2));
 			}
 	}
@@ -251,6 +257,9 @@ namespace claujson {
 				}
 
 				json.set_parent(StructuredPtr(this));
+				if (obj_data.empty()) {
+					obj_data.reserve(item_num);
+				}
 				obj_data.push_back({ std::move(temp), _Value(json) });
 
 			}
@@ -263,6 +272,9 @@ namespace claujson {
 				}
 
 				json.set_parent(StructuredPtr(this));
+				if (obj_data.empty()) {
+					obj_data.reserve(item_num);
+				}
 				obj_data.push_back({ std::move(temp), _Value(json) });
 
 			}
@@ -291,6 +303,9 @@ namespace claujson {
 			}
 
 			json.set_parent(this);
+			if (arr_vec.empty()) {
+				arr_vec.reserve(item_num);
+			}
 			arr_vec.push_back(_Value(json));
 
 		}
@@ -323,6 +338,9 @@ namespace claujson {
 			val.Get().as_object()->set_parent(this);
 		}
 
+		if (obj_data.empty()) {
+			obj_data.reserve(item_num);
+		}
 		obj_data.push_back({ std::move(key.Get()), std::move(val.Get()) });
 
 		return true;
@@ -355,15 +373,18 @@ namespace claujson {
 			val.Get().as_object()->set_parent(this);
 		}
 
+		if (arr_vec.empty()) {
+			arr_vec.reserve(item_num);
+		}
 		arr_vec.push_back(std::move(val.Get()));
 
 		return true;
 	}
-	void  PartialJson::MergeWith(Array* j, int start_offset) {
+	void  PartialJson::MergeWith(Array* j, int start_offset, bool update_parent) {
 		auto* x = j;
 
 		uint64_t len = j->get_data_size();
-		for (uint64_t i = 0; i < len; ++i) {
+		for (uint64_t i = (update_parent || len == 0) ? 0 : len - 1; i < len; ++i) {
 			if (j->get_value_list(i).is_array()) {
 				j->get_value_list(i).as_array()->set_parent(this);
 			}
@@ -380,14 +401,14 @@ namespace claujson {
 			log << info << "test5";
 		}
 	}
-	void  PartialJson::MergeWith(Object* j, int start_offset) {
+	void  PartialJson::MergeWith(Object* j, int start_offset, bool update_parent) {
 		ERROR("PartialJson::MergeWith Error");
 	}
-	void  PartialJson::MergeWith(PartialJson* j, int start_offset) {
+	void  PartialJson::MergeWith(PartialJson* j, int start_offset, bool update_parent) {
 		auto* x = dynamic_cast<PartialJson*>(j);
 
 		uint64_t len = j->get_data_size();
-		for (uint64_t i = 0; i < len; ++i) {
+		for (uint64_t i = (update_parent || len == 0) ? 0 : len - 1; i < len; ++i) {
 			if (j->get_value_list(i).is_array()) {
 				j->get_value_list(i).as_array()->set_parent(this);
 			}
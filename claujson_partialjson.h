@@ -13,6 +13,8 @@ namespace claujson {
 
 		Arena* pool;
 
+		uint64_t item_num = 0; // max number of items at depth 0 of this part, (from is_valid2) reserved at first item.
+
 		static _Value data_null; // valid is false..
 		static const uint64_t npos; // 
 	public:
@@ -70,9 +72,9 @@ namespace claujson {
 		bool add_array_element(Value val);
 
 	public:
-		void MergeWith(Array* j, int start_offset);
-		void MergeWith(Object* j, int start_offset);
-		void MergeWith(PartialJson* j, int start_offset);
+		void MergeWith(Array* j, int start_offset, bool update_parent = true); // update_parent == false -> only parent of last item is updated.
+		void MergeWith(Object* j, int start_offset, bool update_parent = true);
+		void MergeWith(PartialJson* j, int start_offset, bool update_parent = true);
 
 	private:
 		void add_item_type(int64_t key_buf_idx, int64_t key_next_buf_idx, int64_t val_buf_idx, int64_t val_next_buf_idx,
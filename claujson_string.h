@@ -7,6 +7,7 @@ namespace claujson {
 	// sz`s type is uint32_t, not uint64_t.
 	class alignas(32) String {
 		friend class _Value;
+		friend class Object; // Object::find
 	private: // do not change of order. do not add variable.
 #define CLAUJSON_STRING_BUF_SIZE 11
 		union {
@@ -22,9 +23,14 @@ namespace claujson {
 			};
 		};
 		Arena* pool = nullptr;
-		uint8_t temp[8];
+		uint8_t shared = 0; // Shared flags, buffer is not freed by clear.
+		uint8_t temp[7];
 	public:
 		static const uint64_t npos = -1;
+
+		enum Shared : uint8_t {
+			SHARED_BUFFER = 1, // not own, (interned key, keys of objects of same layout, in input)
+		};
 	public:
 		String& operator=(const String& other) = delete;
 
@@ -36,6 +42,7 @@ namespace claujson {
 			std::swap(this->sz, other.sz);
 			std::swap(this->type, other.type);
 			std::swap(this->pool, other.pool);
+			std::swap(this->shared, other.shared);
 		}
 
 	public:
@@ -46,11 +53,14 @@ namespace claujson {
 		}
 
 		~String() {
-			if (type == _ValueType::STRING && str && !pool) {
+			if (shared & SHARED_BUFFER) {
+				//
+			}
+			else if (type == _ValueType::STRING && str && !pool) {
 				delete[] str; 
 			}
 			else if (type == _ValueType::STRING && str) {
-				pool->deallocate<char>(str, static_cast<uint64_t>(sz + 1));
+				pool->deallocate_str(str, static_cast<uint64_t>(sz));
 			}
 			str = nullptr;
 			sz = 0;
@@ -97,6 +107,7 @@ namespace claujson {
 			std::swap(this->sz, other.sz);
 			std::swap(this->type, other.type);
 			std::swap(this->pool, other.pool); // check!
+			std::swap(this->shared, other.shared);
 			return *this;
 		}
 
@@ -208,17 +219,21 @@ namespace claujson {
 			}
 		}
 
-		// remove data.
+		// remove data. (buffer not own is not freed)
 		void clear() {
-			if (type == _ValueType::STRING && str && !pool) {
+			if (shared & SHARED_BUFFER) {
+				//
+			}
+			else if (type == _ValueType::STRING && str && !pool) {
 				delete[] str;
 			}
 			else if (type == _ValueType::STRING && str) {
-				pool->deallocate<char>(str, static_cast<uint64_t>(sz + 1));
+				pool->deallocate_str(str, static_cast<uint64_t>(sz));
 			}
 			sz = 0;
 			str = nullptr;
 			type = _ValueType::NONE;
+			shared = 0;
 		}
 
 		bool operator<(const String& other) const {
@@ -236,6 +251,7 @@ namespace claujson {
 
 		bool operator==(const String& other) const {
 			if (!this->is_valid() || !other.is_valid()) { return false; }
+			if (type == _ValueType::STRING && other.type == _ValueType::STRING && str == other.str) { return sz == other.sz; } // interned keys
 			return StringView(data(), size()) == StringView(other.data(), other.size());
 		}
 
@@ -1,4 +1,5 @@
 ﻿#include "claujson.h"
+#include <atomic>
 
 namespace claujson {
 	extern Log log;
@@ -10,7 +11,7 @@ namespace claujson {
 
 		_Value x;
 
-		x._type = this->_type;
+		x._type = this->type();
 
 		if (this->is_str()) {
 			x.set_str_in_parse(pool, this->_str_val->data(), this->_str_val->size());
@@ -151,36 +152,159 @@ namespace claujson {
 		}
 	}
 
+	_ValueType _Value::load_type() const {
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<_ValueType>(__atomic_load_n(reinterpret_cast<const int32_t*>(&_type), __ATOMIC_ACQUIRE));
+#else
+		const _ValueType type = *static_cast<const volatile _ValueType*>(&_type);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return type;
+#endif
+	}
+
+	void _Value::store_type(_ValueType type) {
+#if defined(__GNUC__) || defined(__clang__)
+		__atomic_store_n(reinterpret_cast<int32_t*>(&_type), static_cast<int32_t>(type), __ATOMIC_RELEASE);
+#else
+		std::atomic_thread_fence(std::memory_order_release);
+		*static_cast<volatile _ValueType*>(&_type) = type;
+#endif
+	}
+
+	void _Value::set_lazy_number(const char* text) {
+		_str_val = nullptr;
+		_int_val = reinterpret_cast<intptr_t>(text);
+		_type = _ValueType::LAZY_NUMBER;
+	}
+
+	bool _Value::set_lazy_str(Arena* pool, const char* text, uint64_t len) {
+		// str -> '"' of input, sz -> length of token, converted in resolve.
+		_str_val = (String*)pool->allocate<String>(sizeof(String));
+		if (!_str_val) {
+			return false;
+		}
+		new (_str_val) String(pool);
+		_str_val->str = const_cast<char*>(text);
+		_str_val->sz = Static_Cast<uint64_t, uint32_t>(len);
+		_type = _ValueType::LAZY_STRING;
+		return true;
+	}
+
+	// text -> '"' of kept input, end('"') of string if it is used in place, (not short, no escape) else nullptr.
+	static char* ZeroCopyEnd(char* text, uint64_t len) {
+		char* str = text + 1;
+		if (len < 2) {
+			return nullptr;
+		}
+		char* end = (char*)memchr(str, '"', len - 1);
+		if (!end || end - str < CLAUJSON_STRING_BUF_SIZE || memchr(str, '\\', end - str)) {
+			return nullptr;
+		}
+		return end;
+	}
+
+	bool _Value::set_str_zero_copy(Arena* pool, char* text, uint64_t len) {
+		char* str = text + 1;
+		char* end = ZeroCopyEnd(text, len);
+		if (!end) {
+			return false;
+		}
+		_str_val = (String*)pool->allocate<String>(sizeof(String));
+		if (!_str_val) {
+			return false;
+		}
+		new (_str_val) String(pool);
+		*end = '\0'; // '"' -> '\0'
+		_str_val->str = str; // not own.
+		_str_val->shared = String::SHARED_BUFFER;
+		_str_val->sz = static_cast<uint32_t>(end - str);
+		_str_val->type = _ValueType::STRING;
+		_type = _ValueType::STRING;
+		return true;
+	}
+
+	bool _Value::resolve_str(Arena* pool) const {
+		String* lazy = _str_val;
+		char* text = lazy->str; // '"' of input.
+		const uint64_t len = lazy->sz;
+
+		char* end = ZeroCopyEnd(text, len);
+		if (end) { // input is kept.
+			*end = '\0';
+			lazy->str = text + 1; // not own.
+			lazy->shared = String::SHARED_BUFFER;
+			lazy->sz = static_cast<uint32_t>(end - (text + 1));
+			lazy->type = _ValueType::STRING;
+			return true;
+		}
+
+		// unescaped size <= len, parse_string writes blocks -> + padding.
+		const uint64_t cap = len + _simdjson::_SIMDJSON_PADDING;
+		uint8_t* buf = pool->allocate<uint8_t>(cap);
+		if (!buf) {
+			return false;
+		}
+		uint8_t* buf_end = _simdjson::parse_string(reinterpret_cast<const uint8_t*>(text) + 1, buf, false);
+		if (!buf_end) {
+			pool->shrink(buf, cap, 0);
+			return false;
+		}
+		const uint32_t sz = static_cast<uint32_t>(buf_end - buf);
+
+		if (sz < CLAUJSON_STRING_BUF_SIZE) { // -> in String.
+			memcpy(lazy->buf, buf, sz);
+			lazy->buf[sz] = '\0';
+			lazy->buf_sz = static_cast<uint8_t>(sz);
+			lazy->type = _ValueType::SHORT_STRING;
+			pool->shrink(buf, cap, 0);
+			return true;
+		}
+
+		*buf_end = '\0';
+		pool->shrink(buf, cap, static_cast<uint64_t>(sz) + 1);
+		lazy->str = reinterpret_cast<char*>(buf);
+		lazy->sz = sz;
+		lazy->type = _ValueType::STRING;
+		return true;
+	}
+
 	_ValueType _Value::type() const {
-		return _type;
+		const _ValueType type = load_type();
+		if (type == _ValueType::LAZY_NUMBER || type == _ValueType::LAZY_STRING) {
+			return resolve();
+		}
+		return type;
 	}
 
 	bool _Value::is_valid() const {
-		return type() != _ValueType::NOT_VALID && type() != _ValueType::ERROR;
+		const _ValueType type = this->type();
+		return type != _ValueType::NOT_VALID && type != _ValueType::ERROR;
 	}
 
 	bool _Value::is_null() const {
-		return is_valid() && type() == _ValueType::NULL_;
+		return load_type() == _ValueType::NULL_;
 	}
 
 	bool _Value::is_primitive() const {
 		return is_valid() && !is_structured();
 	}
 
+	// not convert lazy values.
 	bool _Value::is_structured() const {
-		return is_valid() && (type() == _ValueType::ARRAY || type() == _ValueType::OBJECT);
+		const _ValueType type = load_type();
+		return type == _ValueType::ARRAY || type == _ValueType::OBJECT;
 	}
 
 	bool _Value::is_array() const {
-		return is_valid() && type() == _ValueType::ARRAY;
+		return load_type() == _ValueType::ARRAY;
 	}
 
 	bool _Value::is_object() const {
-		return is_valid() && type() == _ValueType::OBJECT;
+		return load_type() == _ValueType::OBJECT;
 	}
 
 	bool _Value::is_partial_json() const {
-		return is_valid() && type() == _ValueType::PARTIAL_JSON;
+		return load_type() == _ValueType::PARTIAL_JSON;
 	}
 
 	bool _Value::is_int() const {
@@ -196,34 +320,41 @@ namespace claujson {
 	}
 
 	bool _Value::is_bool() const {
-		return is_valid() && (type() == _ValueType::BOOL);
+		return load_type() == _ValueType::BOOL;
 	}
 
 	bool _Value::is_str() const {
-		return is_valid() && (type() == _ValueType::STRING || type() == _ValueType::SHORT_STRING);
+		const _ValueType type = this->type();
+		return type == _ValueType::STRING || type == _ValueType::SHORT_STRING;
 	}
 
 	int64_t _Value::int_val() const {
+		type();
 		return _int_val;
 	}
 
 	uint64_t _Value::uint_val() const {
+		type();
 		return _uint_val;
 	}
 
 	double _Value::float_val() const {
+		type();
 		return _float_val;
 	}
 
 	int64_t& _Value::int_val() {
+		type();
 		return _int_val;
 	}
 
 	uint64_t& _Value::uint_val() {
+		type();
 		return _uint_val;
 	}
 
 	double& _Value::float_val() {
+		type();
 		return _float_val;
 	}
 
@@ -329,16 +460,31 @@ namespace claujson {
 	}
 
 
+	void _Value::remap_key(const Arena* pool) {
+		if (is_str() && _str_val->type == _ValueType::STRING && (_str_val->shared & String::SHARED_BUFFER)) {
+			char* str = pool->find_key(_str_val->str, _str_val->sz);
+			if (str) {
+				_str_val->str = str;
+			}
+		}
+	}
+
+	void _Value::release_str() {
+		Arena* pool = _str_val->pool;
+		_str_val->clear();
+		if (pool) {
+			pool->deallocate<String>(_str_val, 1);
+		}
+		else {
+			delete _str_val;
+		}
+		_str_val = nullptr;
+	}
+
 	void _Value::clear(bool remove_str) {
 
 		if (remove_str && is_str()) {
-			_str_val->clear();
-			if (_str_val->pool) {
-				//
-			}
-			else {
-				delete _str_val;
-			}
+			release_str();
 			_int_val = 0;
 			//temp = 0;
 			_type = _ValueType::NONE;
@@ -355,11 +501,13 @@ namespace claujson {
 
 	String& _Value::str_val() {
 		// type check...
+		type();
 		return *_str_val;
 	}
 
 	const String& _Value::str_val() const {
 		// type check...
+		type();
 		return *_str_val;
 	}
 
@@ -369,13 +517,7 @@ namespace claujson {
 		}
 
 		if (is_str()) {
-			_str_val->clear();
-			if (_str_val->pool) {
-				//
-			}
-			else {
-				delete _str_val;
-			}
+			release_str();
 		}
 		_int_val = x;
 		_type = _ValueType::INT;
@@ -386,13 +528,7 @@ namespace claujson {
 			return;
 		}
 		if (is_str()) {
-			_str_val->clear();
-			if (_str_val->pool) {
-				//
-			}
-			else {
-				delete _str_val;
-			}
+			release_str();
 		}
 		_uint_val = x;
 		_type = _ValueType::UINT;
@@ -403,13 +539,7 @@ namespace claujson {
 			return;
 		}
 		if (is_str()) {
-			_str_val->clear();
-			if (_str_val->pool) {
-				//
-			}
-			else {
-				delete _str_val;
-			}
+			release_str();
 		}
 		_float_val = x;
 
@@ -569,18 +699,96 @@ namespace claujson {
 		_type = _ValueType::STRING;
 	}
 
+	void _Value::set_key_in_parse(Arena* pool, const char* str, uint64_t len) {
+		char* shared = nullptr;
+		if (pool && len >= CLAUJSON_STRING_BUF_SIZE) {
+			shared = pool->intern(str, Static_Cast<uint64_t, uint32_t>(len));
+		}
+		if (!shared) {
+			set_str_in_parse(pool, str, len);
+			return;
+		}
+		_str_val = (String*)pool->allocate<String>(sizeof(String));
+		new (_str_val) String(pool);
+		_str_val->str = shared; // not own.
+		_str_val->shared = String::SHARED_BUFFER;
+		_str_val->sz = static_cast<uint32_t>(len);
+		_str_val->type = _ValueType::STRING;
+		_type = _ValueType::STRING;
+	}
+
+	bool _Value::set_str_unescape(Arena* pool, const char* text, uint64_t len, bool key, const _Value* shape_key) {
+		// unescaped size <= len, parse_string writes blocks -> + padding.
+		const uint64_t cap = len + _simdjson::_SIMDJSON_PADDING;
+		uint8_t* buf = pool->allocate<uint8_t>(cap);
+		if (!buf) {
+			return false;
+		}
+		uint8_t* end = _simdjson::parse_string(reinterpret_cast<const uint8_t*>(text) + 1, buf, false);
+		if (!end) {
+			pool->shrink(buf, cap, 0);
+			return false;
+		}
+		*end = '\0';
+		const uint32_t sz = static_cast<uint32_t>(end - buf);
+		char* str = reinterpret_cast<char*>(buf);
+
+		// key has own String, buffer is shared with key of object of same layout. (short one is in String)
+		if (shape_key && sz >= CLAUJSON_STRING_BUF_SIZE && shape_key->is_str() && shape_key->_str_val->type == _ValueType::STRING
+			&& shape_key->_str_val->sz == sz && memcmp(shape_key->_str_val->str, str, sz) == 0) {
+			pool->shrink(buf, cap, 0);
+			_str_val = (String*)pool->allocate<String>(sizeof(String));
+			if (!_str_val) {
+				return false;
+			}
+			new (_str_val) String(pool);
+			shape_key->_str_val->shared = String::SHARED_BUFFER; // first one does not free it too.
+			_str_val->str = shape_key->_str_val->str;
+			_str_val->shared = String::SHARED_BUFFER;
+			_str_val->sz = sz;
+			_str_val->type = _ValueType::STRING;
+			_type = _ValueType::STRING;
+			return true;
+		}
+
+		if (sz < CLAUJSON_STRING_BUF_SIZE) { // -> in String.
+			char short_str[CLAUJSON_STRING_BUF_SIZE];
+			memcpy(short_str, str, sz);
+			pool->shrink(buf, cap, 0);
+			_str_val = (String*)pool->allocate<String>(sizeof(String));
+			if (!_str_val) {
+				return false;
+			}
+			new (_str_val) String(pool, short_str, sz);
+			_type = _ValueType::STRING;
+			return true;
+		}
+
+		char* shared = key ? pool->intern_in_place(str, sz) : nullptr;
+		pool->shrink(buf, cap, shared && shared != str ? 0 : static_cast<uint64_t>(sz) + 1);
+		if (shared) {
+			str = shared;
+		}
+
+		_str_val = (String*)pool->allocate<String>(sizeof(String));
+		if (!_str_val) {
+			return false;
+		}
+		new (_str_val) String(pool);
+		_str_val->str = str; // in pool.
+		_str_val->shared = shared ? String::SHARED_BUFFER : 0; // interned -> buffer of KeyTable.
+		_str_val->sz = sz;
+		_str_val->type = _ValueType::STRING;
+		_type = _ValueType::STRING;
+		return true;
+	}
+
 	void _Value::set_bool(bool x) {
 		if (!is_valid()) {
 			return;
 		}
 		if (is_str()) {
-			_str_val->clear();
-			if (_str_val->pool) {
-				//
-			}
-			else {
-				delete _str_val;
-			}
+			release_str();
 		}
 
 		_bool_val = x;
@@ -595,13 +803,7 @@ namespace claujson {
 			return;
 		}
 		if (is_str()) {
-			_str_val->clear();
-			if (_str_val->pool) {
-				//
-			}
-			else {
-				delete _str_val; _str_val = nullptr;
-			}
+			release_str();
 		}
 
 		set_type(_ValueType::NONE);
@@ -612,13 +814,7 @@ namespace claujson {
 			return;
 		}
 		if (is_str()) {
-			_str_val->clear();
-			if (_str_val->pool) {
-				//
-			}
-			else {
-				delete _str_val; _str_val = nullptr;
-			}
+			release_str();
 		}
 
 		set_type(_ValueType::NULL_);
@@ -635,7 +831,8 @@ namespace claujson {
 	_Value::_Value(_Value&& other) noexcept
 		: _type(_ValueType::NONE)
 	{
-		if (!other.is_valid()) {
+		const _ValueType type = other.load_type(); // not convert lazy value.
+		if (type == _ValueType::NOT_VALID || type == _ValueType::ERROR) {
 			return;
 		}
 
@@ -648,8 +845,9 @@ namespace claujson {
 	_Value::_Value() : _int_val(0), _type(_ValueType::NONE) {}
 
 	bool _Value::operator==(const _Value& other) const { // chk array or object?
-		if (this->_type == other._type) {
-			switch (this->_type) {
+		const _ValueType type = this->type();
+		if (type == other.type()) {
+			switch (type) {
 			case _ValueType::STRING:
 			case _ValueType::SHORT_STRING:
 				return *this->_str_val == *other._str_val;
@@ -725,8 +923,9 @@ namespace claujson {
 	}
 
 	bool _Value::operator<(const _Value& other) const {
-		if (this->_type == other._type) {
-			switch (this->_type) {
+		const _ValueType type = this->type();
+		if (type == other.type()) {
+			switch (type) {
 			case _ValueType::STRING:
 			case _ValueType::SHORT_STRING:
 				return *this->_str_val < *other._str_val;
@@ -755,7 +954,8 @@ namespace claujson {
 			return *this;
 		}
 
-		if (!is_valid()) {
+		const _ValueType type = load_type(); // not convert lazy value.
+		if (type == _ValueType::NOT_VALID || type == _ValueType::ERROR) {
 			return *this;
 		}
 
@@ -900,4 +1100,19 @@ namespace claujson {
 		return empty_value;
 	}
 
+	_Value& _Value::operator[](const KeyHandle& key) { // if not exist key, then nothing.
+		if (is_object()) {
+			return as_object()->operator[](key);
+		}
+
+		return empty_value;
+	}
+	const _Value& _Value::operator[](const KeyHandle& key) const { // if not exist key, then nothing.
+		if (is_object()) {
+			return as_object()->operator[](key);
+		}
+
+		return empty_value;
+	}
+
 }
@@ -10,6 +10,7 @@
 //#include "mimalloc-new-delete.h"
 
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <ctime>
 
@@ -18,6 +19,78 @@
 #include "_simdjson.h"
 
 #include <cstring>
+#include <atomic>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#ifdef CLAUJSON_COUNT_NEW // benchmark build only, (CMake target claujson_bench) not with mimalloc-new-delete.h
+#include <new>
+#include <cstdlib>
+
+static std::atomic<uint64_t> new_count{ 0 };
+
+void* operator new(std::size_t size) {
+	new_count.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+#endif
+
+// count of operator new, 0 if not counted.
+static uint64_t new_num() {
+#ifdef CLAUJSON_COUNT_NEW
+	return new_count.load(std::memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+
+// ", new per parse x" if operator new is counted, else "".
+static std::string new_per_parse(uint64_t count, uint64_t parse_num) {
+#ifdef CLAUJSON_COUNT_NEW
+	return ", new per parse " + std::to_string(double(new_num() - count) / parse_num);
+#else
+	return "";
+#endif
+}
+
+// minor page faults of this process, 0 if windows.
+static uint64_t minor_faults() {
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		return usage.ru_minflt;
+	}
+#endif
+	return 0;
+}
+
+// resident memory (KB) of this process, 0 if not linux.
+static uint64_t rss_kb() {
+#ifdef __linux__
+	std::ifstream in("/proc/self/status");
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.compare(0, 6, "VmRSS:") == 0) {
+			return std::strtoull(line.c_str() + 6, nullptr, 10);
+		}
+	}
+#endif
+	return 0;
+}
 
 // using namespace std::literals::u8string_view_literals; // ?? 
 
@@ -105,6 +178,457 @@ void diff_test() {
 	//claujson::clean(z);
 }
 
+// big input with a stray '"' (or ndjson with an unclosed line) -> parse error at once, for every thread count. (not scanned again and again)
+bool malformed_test() {
+	std::cout << "malformed test\n";
+
+	std::string str = "[";
+	for (int i = 0; i < 300000; ++i) {
+		str += (i ? "," : "");
+		str += "{\"id\":" + std::to_string(i) + ",\"name\":\"record name number " + std::to_string(i) + "\"}";
+	}
+	str += "]";
+	str.insert(str.size() / 3, "\"");
+
+	claujson::parser p;
+	for (uint64_t thr_num = 1; thr_num <= 8; thr_num *= 2) {
+		claujson::Document d;
+
+		auto a = std::chrono::steady_clock::now();
+		const bool ok = p.parse_str(str, d, thr_num).first;
+		auto b = std::chrono::steady_clock::now();
+
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+		std::cout << "unclosed string, parse_str " << thr_num << " threads " << dur.count() << "ms\n";
+		if (ok) {
+			return false;
+		}
+	}
+
+	{
+		std::ofstream out("malformed.json", std::ios::binary);
+		out << str;
+	}
+	bool ok = true;
+	for (uint64_t thr_num = 1; thr_num <= 8 && ok; thr_num *= 2) {
+		claujson::Document d;
+
+		auto a = std::chrono::steady_clock::now();
+		const bool result = p.parse_pipelined("malformed.json", d, thr_num).first;
+		auto b = std::chrono::steady_clock::now();
+
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+		std::cout << "unclosed string, parse_pipelined " << thr_num << " threads " << dur.count() << "ms\n";
+		ok = !result;
+	}
+	std::remove("malformed.json");
+	if (!ok) {
+		return false;
+	}
+
+	// ndjson, one line is not closed.
+	{
+		std::ofstream out("malformed.ndjson", std::ios::binary);
+		for (int i = 0; i < 300000; ++i) {
+			if (i == 100000) {
+				out << "{\"id\":" << i << ",\"name\":\"record name number}\n";
+				continue;
+			}
+			out << "{\"id\":" << i << ",\"name\":\"record name number " << i << "\"}\n";
+		}
+	}
+	for (uint64_t thr_num = 1; thr_num <= 8 && ok; thr_num *= 2) {
+		claujson::Document d;
+
+		auto a = std::chrono::steady_clock::now();
+		const bool result = p.parse_ndjson("malformed.ndjson", d, thr_num).first;
+		auto b = std::chrono::steady_clock::now();
+
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+		std::cout << "unclosed string, parse_ndjson " << thr_num << " threads " << dur.count() << "ms\n";
+		ok = !result;
+	}
+	std::remove("malformed.ndjson");
+	return ok;
+}
+
+// patch removes a field of each record, then new keys are added. shared keys (interned, or shape share) must not be reused.
+// mode 0 : key interning, 1 : shape share, turned off after parse.
+bool shared_key_patch_test(int mode) {
+	const int n = 100000;
+	std::string str = "[";
+	std::string ops = "[";
+	for (int i = 0; i < n; ++i) {
+		str += (i ? "," : "");
+		str += "{\"record_identifier\":" + std::to_string(i)
+			+ ",\"detail_object\":{\"long_inner_key_alpha\":1,\"long_inner_key_beta\":\"b\"},\"description_text\":\"d\"}";
+		ops += (i ? "," : "");
+		ops += "{\"op\":\"remove\",\"path\":[" + std::to_string(i) + "],\"last_key\":\"detail_object\"}";
+	}
+	str += "]";
+	ops += "]";
+
+	claujson::parser p;
+	claujson::Document d, diff;
+	if (mode == 0) {
+		d.EnableKeyIntern(true);
+	}
+	else {
+		d.EnableShapeShare(true);
+	}
+	if (!p.parse_str(str, d, 4).first || !p.parse_str(ops, diff, 1).first) {
+		return false;
+	}
+	if (mode == 1) {
+		d.EnableShapeShare(false);
+
+		// own String of each key, buffer of long key is shared.
+		const claujson::String& x = d.Get().as_array()->get_value_list(1).as_object()->begin()[0].first.get_string();
+		const claujson::String& y = d.Get().as_array()->get_value_list(2).as_object()->begin()[0].first.get_string();
+		if (&x == &y || x.data() != y.data()) {
+			return false;
+		}
+	}
+	else {
+		// keys of first and last part, one copy in table of d.
+		const claujson::String& x = d.Get().as_array()->get_value_list(1).as_object()->begin()[2].first.get_string();
+		const claujson::String& y = d.Get().as_array()->get_value_list(n - 1).as_object()->begin()[2].first.get_string();
+		if (x.data() != y.data()) {
+			return false;
+		}
+	}
+
+	claujson::patch(d.GetAllocator(), d.Get(), diff.Get());
+
+	claujson::Arena* pool = d.GetAllocator();
+	claujson::Array* arr = d.Get().as_array();
+	for (int i = 0; i < n; ++i) {
+		arr->get_value_list(i).as_object()->add_element(claujson::_Value(pool, "a new key of the record"sv), claujson::_Value(pool, "a new value of the record"sv));
+	}
+
+	// keys of record 0 are cleared and set, keys of other records must not change.
+	{
+		auto it = arr->get_value_list(0).as_object()->begin();
+		it[0].first.set_int(0);
+		it[1].first.clear(true);
+		it[1].first.set_str(pool, "renamed key of record zero", 26);
+	}
+
+	const claujson::_Value key[3] = { claujson::_Value(pool, "record_identifier"sv), claujson::_Value(pool, "description_text"sv),
+		claujson::_Value(pool, "a new key of the record"sv) };
+	uint64_t bad = 0;
+	if (!(arr->get_value_list(0).as_object()->begin()[1].first.get_string() == claujson::StringView("renamed key of record zero", 26))) {
+		++bad;
+	}
+	for (int i = 1; i < n; ++i) {
+		const claujson::Object* obj = arr->get_value_list(i).as_object();
+		if (obj->get_data_size() != 3 || obj->find(key[0]) != 0 || obj->find(key[1]) != 1 || obj->find(key[2]) != 2) {
+			++bad;
+		}
+	}
+	std::cout << "shared key patch test, mode " << mode << ", bad records " << bad << "\n";
+	return bad == 0;
+}
+
+// count of containers with capacity != size.
+uint64_t count_inexact(const claujson::_Value& x) {
+	uint64_t count = 0;
+	if (x.is_array()) {
+		const claujson::Array* arr = x.as_array();
+		count += arr->get_data_capacity() != arr->get_data_size();
+		for (uint64_t i = 0; i < arr->get_data_size(); ++i) {
+			count += count_inexact(arr->get_value_list(i));
+		}
+	}
+	else if (x.is_object()) {
+		const claujson::Object* obj = x.as_object();
+		count += obj->get_data_capacity() != obj->get_data_size();
+		for (uint64_t i = 0; i < obj->get_data_size(); ++i) {
+			count += count_inexact(obj->get_value_list(i));
+		}
+	}
+	return count;
+}
+
+// parse_str, one pass and two pass, reserves each container exactly.
+bool exact_capacity_test() {
+	std::string str = "[";
+	for (int i = 0; i < 100000; ++i) {
+		str += (i ? "," : "");
+		str += "{\"id\":" + std::to_string(i) + ",\"name\":\"record\",\"tags\":[";
+		for (int j = 0; j < i % 7; ++j) {
+			str += (j ? "," : "");
+			str += std::to_string(j);
+		}
+		str += "]}";
+	}
+	str += "]";
+
+	for (int fused = 0; fused < 2; ++fused) {
+		for (int thr_num : { 1, 4 }) {
+			claujson::parser p;
+			claujson::Document d;
+			p.set_fused(fused == 1);
+			if (!p.parse_str(str, d, thr_num).first) {
+				return false;
+			}
+			const uint64_t bad = count_inexact(d.Get());
+			const uint64_t regrow = d.GetStats().regrow_num;
+			std::cout << "exact capacity test, fused " << fused << ", thr " << thr_num << ", bad containers " << bad
+				<< ", reallocations " << regrow << "\n";
+			if (bad) {
+				return false;
+			}
+			// two pass (default) reserves with count of items, no reallocation. one pass grows and trims.
+			if (fused == 0 && regrow != 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// const find of many large objects of one Document from many threads, (hash index is built by parse, find does not allocate)
+bool concurrent_find_test() {
+	const int n = 1000; // keys of one object.
+	const int m = 64; // objects.
+	std::string str = "[";
+	for (int j = 0; j < m; ++j) {
+		str += (j ? ",{" : "{");
+		for (int i = 0; i < n; ++i) {
+			str += (i ? "," : "");
+			str += "\"key_of_the_object_" + std::to_string(i) + "\":" + std::to_string(j);
+		}
+		str += "}";
+	}
+	str += "]";
+
+	std::atomic<uint64_t> bad{ 0 };
+	for (int thr_num : { 1, 4 }) {
+		claujson::parser p;
+		claujson::Document d;
+		if (!p.parse_str(str, d, thr_num).first) {
+			return false;
+		}
+		claujson::Arena* pool = d.GetAllocator();
+		std::vector<claujson::_Value> key;
+		for (int i = 0; i < n; ++i) {
+			key.emplace_back(pool, ("key_of_the_object_" + std::to_string(i)).c_str());
+		}
+		const claujson::Array* arr = d.Get().as_array();
+		for (int j = 0; j < m; ++j) {
+			if (!arr->get_value_list(j).as_object()->has_index()) {
+				++bad;
+			}
+		}
+		const uint64_t used = d.GetStats().total_used();
+
+		std::vector<std::thread> thr;
+		for (int t = 0; t < 8; ++t) {
+			thr.emplace_back([&, t]() {
+				for (int j = 0; j < m; ++j) {
+					const claujson::Object* obj = arr->get_value_list((j + t * 7) % m).as_object();
+					for (int i = 0; i < n; ++i) {
+						const int k = (i + t * 127) % n;
+						if (obj->find(key[k]) != (uint64_t)k) {
+							++bad;
+						}
+					}
+				}
+			});
+		}
+		for (auto& x : thr) {
+			x.join();
+		}
+		if (d.GetStats().total_used() != used) { // find allocated.
+			++bad;
+		}
+	}
+	std::cout << "concurrent find test, bad " << bad << "\n";
+	return bad == 0;
+}
+
+// first access of lazy values from many threads, escaped strings are unescaped into new buffers.
+bool lazy_concurrent_test() {
+	const int n = 100000;
+	auto expected = [](int i) {
+		return (i % 3 == 1) ? "escaped \"string\" number " + std::to_string(i) : "s\t" + std::to_string(i % 1000);
+	};
+	std::string str = "[";
+	for (int i = 0; i < n; ++i) {
+		str += (i ? "," : "");
+		if (i % 3 == 0) {
+			str += std::to_string(i);
+		}
+		else if (i % 3 == 1) {
+			str += "\"escaped \\\"string\\\" number " + std::to_string(i) + "\"";
+		}
+		else {
+			str += "\"s\\t" + std::to_string(i % 1000) + "\"";
+		}
+	}
+	str += "]";
+
+	std::atomic<uint64_t> bad{ 0 };
+	claujson::parser p;
+	claujson::Document d;
+	d.EnableLazy(true);
+	if (!p.parse_str(str, d, 4).first) {
+		return false;
+	}
+	const claujson::Array* arr = d.Get().as_array();
+
+	std::vector<std::thread> thr;
+	for (int t = 0; t < 8; ++t) {
+		thr.emplace_back([&, t]() {
+			for (int j = 0; j < n; ++j) {
+				const int i = (j + t * 12345) % n;
+				const claujson::_Value& x = arr->get_value_list(i);
+				if (i % 3 == 0) {
+					if (!x.is_int() || x.get_integer() != i) {
+						++bad;
+					}
+				}
+				else if (!x.is_str() || !(x.get_string() == claujson::StringView(expected(i).data(), expected(i).size()))) {
+					++bad;
+				}
+			}
+		});
+	}
+	for (auto& x : thr) {
+		x.join();
+	}
+	std::cout << "lazy concurrent test, bad " << bad << "\n";
+	return bad == 0;
+}
+
+// zero copy and lazy -> Document keeps input of parser (or mapped file), not a copy. values stay after next parse.
+bool kept_input_test() {
+	const int n = 1000;
+	const std::string text(100, 'x');
+	std::string str = "[";
+	for (int i = 0; i < n; ++i) {
+		str += (i ? ",\"" : "\"") + text + std::to_string(i) + "\"";
+	}
+	str += "]";
+	{
+		std::ofstream out("kept_input.json", std::ios::binary);
+		out << str;
+	}
+
+	claujson::parser p;
+	claujson::Document d[3];
+	for (auto& x : d) {
+		x.EnableZeroCopy(true);
+	}
+	d[2].EnableLazy(true);
+	const bool ok = p.parse_str(str, d[0], 1).first && p.parse_mmap("kept_input.json", d[1], 1).first
+		&& p.parse("kept_input.json", d[2], 1).first;
+	std::remove("kept_input.json");
+	if (!ok) {
+		return false;
+	}
+	str.assign(str.size(), ' ');
+
+	uint64_t bad = 0;
+	for (auto& x : d) {
+		const claujson::Array* arr = x.Get().as_array();
+		for (int i = 0; i < n; ++i) {
+			const std::string expected = text + std::to_string(i);
+			if (!(arr->get_value_list(i).get_string() == claujson::StringView(expected.data(), expected.size()))) {
+				++bad;
+			}
+		}
+		if (x.GetStats().total_used() >= str.size()) { // input is copied.
+			++bad;
+		}
+	}
+	std::cout << "kept input test, bad " << bad << "\n";
+	return bad == 0;
+}
+
+// threads add objects and strings to their own array of one Document and replace strings, each from its shard.
+// (with thread sanitizer, CMake target claujson_tsan) then shards are merged twice, and the Document is parsed again.
+bool shard_stress_test(int thr_num, int n) {
+	std::string str = "{ \"parts\" : [";
+	for (int t = 0; t < thr_num; ++t) {
+		str += (t ? "," : "");
+		str += "{\"name\":\"part number " + std::to_string(t) + " of the document\", \"items\":[1,2,3]}";
+	}
+	str += "] }";
+
+	claujson::parser p(1);
+	claujson::Document d;
+	if (!p.parse_str(str, d, 1).first) {
+		return false;
+	}
+	d.EnableShards(true);
+	claujson::Array* parts = d.Get().as_object()->get_value_list(0).as_array();
+
+	uint64_t bad = 0;
+	for (int round = 0; round < 2; ++round) {
+		d.GetAllocator(); // shard of this thread, cached until MergeShards.
+
+		std::vector<std::thread> thr;
+		for (int t = 0; t < thr_num; ++t) {
+			thr.emplace_back([&, t]() {
+				claujson::Arena* pool = d.GetAllocator();
+				claujson::Array* items = parts->get_value_list(t).as_object()->get_value_list(1).as_array();
+				for (int i = 0; i < n; ++i) {
+					const std::string value = "value " + std::to_string(i) + " of thread " + std::to_string(t);
+					if (i % 3 == 0) {
+						claujson::_Value obj = claujson::Object::Make(pool);
+						obj.as_object()->add_element(claujson::_Value(pool, "a long key of object"sv), claujson::_Value(pool, claujson::StringView(value)));
+						obj.as_object()->add_element(claujson::_Value(pool, "n"sv), claujson::_Value(i));
+						items->add_element(std::move(obj));
+					}
+					else {
+						items->add_element(claujson::_Value(pool, claujson::StringView(value)));
+					}
+					if (i % 5 == 4) { // string of last item -> freed, and new one.
+						claujson::_Value& last = items->get_value_list(items->get_data_size() - 1);
+						if (last.is_str()) {
+							last.clear(true);
+							last = claujson::_Value(pool, "replaced string value, long"sv);
+						}
+					}
+				}
+			});
+		}
+		for (auto& x : thr) {
+			x.join();
+		}
+		d.MergeShards();
+
+		// after merge, this thread gets new shard. (not cached one, it is linked to root)
+		const uint64_t arena_num = d.GetStats().arena_num;
+		claujson::Arena* pool = d.GetAllocator();
+		if (d.GetStats().arena_num != arena_num + 1) {
+			++bad;
+		}
+		parts->get_value_list(0).as_object()->get_value_list(1).as_array()->add_element(claujson::_Value(pool, "after merge, value string"sv));
+		d.MergeShards();
+	}
+
+	uint64_t total = 0;
+	for (int t = 0; t < thr_num; ++t) {
+		total += parts->get_value_list(t).as_object()->get_value_list(1).as_array()->get_data_size();
+	}
+	if (total != (uint64_t)thr_num * (2 * n + 3) + 2) {
+		++bad;
+	}
+	claujson::writer w;
+	if (w.write_to_str(d.Get()).empty()) {
+		++bad;
+	}
+	d.GetAllocator();
+	if (!p.parse_str(str, d, 1).first) { // Reset merges shards.
+		++bad;
+	}
+	std::cout << "shard stress test, threads " << thr_num << ", bad " << bad << "\n";
+	return bad == 0;
+}
+
 /*
 enum class ValueType {
 	none,
@@ -546,6 +1070,35 @@ int main(int argc, char* argv[])
 
 	diff_test();
 	std::cout << "----------\n";
+	if (!malformed_test()) {
+		std::cout << "fail (malformed test)\n";
+		return 1;
+	}
+	if (!shared_key_patch_test(0) || !shared_key_patch_test(1)) {
+		std::cout << "fail (shared key patch test)\n";
+		return 1;
+	}
+	if (!exact_capacity_test()) {
+		std::cout << "fail (exact capacity test)\n";
+		return 1;
+	}
+	if (!concurrent_find_test()) {
+		std::cout << "fail (concurrent find test)\n";
+		return 1;
+	}
+	if (!lazy_concurrent_test()) {
+		std::cout << "fail (lazy concurrent test)\n";
+		return 1;
+	}
+	if (!kept_input_test()) {
+		std::cout << "fail (kept input test)\n";
+		return 1;
+	}
+	if (!shard_stress_test(4, 20000) || !shard_stress_test(16, 5000)) {
+		std::cout << "fail (shard stress test)\n";
+		return 1;
+	}
+	std::cout << "----------\n";
 	//diff_test2();
 	std::cout << "----------\n";
 	if(1){
@@ -644,6 +1197,124 @@ int main(int argc, char* argv[])
 	claujson::Document j;
 	claujson::parser p;
 
+	{ // many tiny documents, (ex) rpc) time, and one part -> no worker Arena. (Arena of document only)
+		const char* docs[] = { "1234567", "-3.25", "\"abc\"", "true", "[1,2,3]", "{\"id\":7}" };
+		const int n = 100000;
+		claujson::Document k;
+
+		const uint64_t count = new_num();
+		auto a = std::chrono::steady_clock::now();
+		for (int i = 0; i < n; ++i) {
+			const char* doc = docs[i % 6];
+			auto x = p.parse_str(claujson::StringView(doc, strlen(doc)), k, 1 + i % 4);
+			if (!x.first || k.GetStats().arena_num != 1) {
+				std::cout << "fail (tiny parse_str)\n";
+				return 1;
+			}
+		}
+		auto b = std::chrono::steady_clock::now();
+
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+		const claujson::ArenaStats stats = k.GetStats();
+		std::cout << "tiny parse_str " << dur.count() << "ms, arenas " << stats.arena_num << ", blocks " << stats.block_num[0] + stats.block_num[1]
+			<< new_per_parse(count, n) << "\n";
+	}
+
+	{ // many patch operations to one Document, memory of removed or replaced values is reused. (rss is flat)
+		const int n = 1000;
+		std::string str = "{ \"items\" : [";
+		for (int i = 0; i < n; ++i) {
+			str += (i ? "," : "");
+			str += "{\"id\":" + std::to_string(i) + ",\"name\":\"record name number " + std::to_string(i)
+				+ "\",\"tags\":[\"first long tag\",\"second long tag\"]}";
+		}
+		str += "] }";
+
+		const std::string record = "{\"id\":-1,\"name\":\"a record added by patch\",\"tags\":[\"added tag of record\"]}";
+		const std::string ops = "[ { \"op\" : \"add\", \"path\" : [\"items\"], \"value\" : " + record + " },"
+			" { \"op\" : \"remove\", \"path\" : [\"items\"], \"last_idx\" : " + std::to_string(n) + " },"
+			" { \"op\" : \"replace\", \"path\" : [\"items\", 3, \"name\"], \"value\" : \"a new name of record 3\" },"
+			" { \"op\" : \"replace\", \"path\" : [\"items\", 5], \"value\" : " + record + " } ]";
+
+		claujson::Document k, diff;
+		if (!p.parse_str(str, k, 1).first || !p.parse_str(ops, diff, 1).first) {
+			std::cout << "fail (patch soak)\n";
+			return 1;
+		}
+
+		const int m = 500000; // * 4 operations.
+		auto a = std::chrono::steady_clock::now();
+		for (int i = 0; i < m; ++i) {
+			if (!claujson::patch(k.GetAllocator(), k.Get(), diff.Get())) {
+				std::cout << "fail (patch soak)\n";
+				return 1;
+			}
+			if ((i + 1) % (m / 5) == 0) {
+				std::cout << "patch soak " << 4ULL * (i + 1) << " ops, rss " << rss_kb() << "KB\n";
+			}
+		}
+		auto b = std::chrono::steady_clock::now();
+
+		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+		std::cout << "patch soak " << dur.count() << "ms, items " << k.Get().as_object()->get_value_list(0).as_array()->get_data_size() << "\n";
+	}
+
+	{ // threads add values to their own part of one Document, each thread allocates from its own Arena shard.
+		const int thr = 4, n = 200000;
+		std::string str = "[";
+		for (int t = 0; t < thr; ++t) {
+			str += (t ? "," : "");
+			str += "{\"thread\":" + std::to_string(t) + ",\"items\":[]}";
+		}
+		str += "]";
+
+		for (int sharded = 0; sharded < 2; ++sharded) {
+			claujson::Document k;
+			if (!p.parse_str(str, k, 1).first) {
+				std::cout << "fail (sharded add)\n";
+				return 1;
+			}
+			k.EnableShards(sharded);
+
+			auto work = [&k, n](int t) {
+				claujson::Arena* pool = k.GetAllocator(); // shard of this thread.
+				claujson::Array* items = k.Get().as_array()->get_value_list(t).as_object()->get_value_list(1).as_array();
+				for (int i = 0; i < n; ++i) {
+					const std::string name = "name of item " + std::to_string(i) + " in thread " + std::to_string(t);
+					claujson::_Value obj = claujson::Object::Make(pool);
+					obj.as_object()->add_element(claujson::_Value(pool, claujson::StringView("id", 2)), claujson::_Value(i));
+					obj.as_object()->add_element(claujson::_Value(pool, claujson::StringView("name", 4)), claujson::_Value(pool, claujson::StringView(name)));
+					items->add_element(std::move(obj));
+				}
+			};
+
+			auto a = std::chrono::steady_clock::now();
+			if (sharded) {
+				std::vector<std::thread> threads;
+				for (int t = 0; t < thr; ++t) {
+					threads.emplace_back(work, t);
+				}
+				for (auto& x : threads) {
+					x.join();
+				}
+				k.MergeShards();
+			}
+			else { // one Arena -> one thread.
+				for (int t = 0; t < thr; ++t) {
+					work(t);
+				}
+			}
+			auto b = std::chrono::steady_clock::now();
+
+			uint64_t items = 0;
+			for (int t = 0; t < thr; ++t) {
+				items += k.Get().as_array()->get_value_list(t).as_object()->get_value_list(1).as_array()->get_data_size();
+			}
+			auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+			std::cout << (sharded ? "add (shards, " : "add (one thread, ") << thr << " parts) " << dur.count() << "ms, items " << items << "\n";
+		}
+	}
+
 	for (int i = 0; i < 20; ++i) {
 		claujson::Arena::counter = 0;
 
@@ -692,6 +1363,13 @@ int main(int argc, char* argv[])
 		}
 
 		std::cout << "counter " << claujson::Arena::counter << "\n";
+		{
+			const claujson::ArenaStats stats = j.GetStats();
+			std::cout << "arena blocks " << stats.block_num[0] << " + " << stats.block_num[1] << " (oversize " << stats.oversize_num << ")"
+				<< ", used " << stats.total_used() / 1024 << "KB of " << stats.total_reserved() / 1024 << "KB"
+				<< ", recycled " << stats.recycled_block_num[0] + stats.recycled_block_num[1] << ", free lists " << stats.free_bytes / 1024 << "KB"
+				<< ", rss " << rss_kb() << "KB\n";
+		}
 		//return 0;
 		//continue;
 		///return 0;
@@ -702,6 +1380,130 @@ int main(int argc, char* argv[])
 		auto b = std::chrono::steady_clock::now();
 		auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
 		std::cout << "total " << dur.count() << "ms\n";
+		std::cout << "imbalance (slowest / average part) " << p.get_imbalance() << "\n";
+
+		{ // load vs mmap
+			claujson::Document k;
+
+			auto a = std::chrono::steady_clock::now();
+			auto x = p.parse_mmap(argv[1], k, thr_num);
+			auto b = std::chrono::steady_clock::now();
+
+			if (!x.first) {
+				std::cout << "fail (mmap)\n";
+
+				return 1;
+			}
+
+			auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+			std::cout << "total (mmap) " << dur.count() << "ms\n";
+		}
+
+		{ // stage1 + tree building, pipelined
+			claujson::Document k;
+
+			auto a = std::chrono::steady_clock::now();
+			auto x = p.parse_pipelined(argv[1], k, thr_num);
+			auto b = std::chrono::steady_clock::now();
+
+			if (!x.first) {
+				std::cout << "fail (pipelined)\n";
+
+				return 1;
+			}
+
+			auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+			std::cout << "total (pipelined) " << dur.count() << "ms\n";
+		}
+
+		{ // lazy, numbers and strings are converted at first access.
+			claujson::Document k;
+			k.EnableLazy(true);
+
+			auto a = std::chrono::steady_clock::now();
+			auto x = p.parse(argv[1], k, thr_num);
+			auto b = std::chrono::steady_clock::now();
+
+			if (!x.first) {
+				std::cout << "fail (lazy)\n";
+
+				return 1;
+			}
+
+			auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+			std::cout << "total (lazy) " << dur.count() << "ms\n";
+		}
+
+		{ // strings without escape point to input, not copied.
+			claujson::Document k;
+			k.EnableZeroCopy(true);
+
+			auto a = std::chrono::steady_clock::now();
+			auto x = p.parse(argv[1], k, thr_num);
+			auto b = std::chrono::steady_clock::now();
+
+			if (!x.first) {
+				std::cout << "fail (zero copy)\n";
+
+				return 1;
+			}
+
+			auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+			std::cout << "total (zero copy) " << dur.count() << "ms\n";
+		}
+
+		for (int huge = 0; huge < 2; ++huge) { // new Document, blocks of 2MB huge pages -> less page faults and TLB misses.
+			claujson::Document k;
+			k.EnableHugePage(huge == 1);
+
+			const uint64_t faults = minor_faults();
+			auto a = std::chrono::steady_clock::now();
+			auto x = p.parse(argv[1], k, thr_num);
+			auto b = std::chrono::steady_clock::now();
+
+			if (!x.first) {
+				std::cout << "fail (new Document)\n";
+
+				return 1;
+			}
+
+			auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(b - a);
+			std::cout << "total (new Document" << (huge ? ", huge page) " : ") ") << dur.count() << "ms, page faults " << minor_faults() - faults << "\n";
+		}
+
+		{ // two pass (is_valid2 + __LoadData) vs one pass (grammar check in __LoadData), input is in memory. best of 3, MB/s of input.
+			std::ifstream in(argv[1], std::ios::binary);
+			std::string str((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			uint64_t length = 0;
+
+			for (int fused = 0; fused < 2; ++fused) {
+				p.set_fused(fused == 1);
+
+				int64_t best = -1;
+				const uint64_t count = new_num();
+				for (int i = 0; i < 3; ++i) {
+					claujson::Document k;
+					auto a = std::chrono::steady_clock::now();
+					auto x = p.parse_str(claujson::StringView(str.data(), str.size()), k, thr_num);
+					auto b = std::chrono::steady_clock::now();
+
+					if (!x.first) {
+						std::cout << "fail (parse_str)\n";
+
+						return 1;
+					}
+					length = x.second;
+					const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(b - a).count();
+					best = best < 0 ? us : std::min(best, us);
+				}
+				std::cout << "total (parse_str, " << (fused ? "one pass) " : "two pass) ") << best / 1000 << "ms, "
+					<< (best > 0 ? str.size() / (double)best : 0) << "MB/s" << new_per_parse(count, 3) << "\n";
+			}
+			p.set_fused(false);
+
+			// is_valid2 pass reads structural indexes (4 bytes per token) and writes count_vec (8 bytes per token), one pass does not.
+			std::cout << "memory swept by is_valid2 pass " << (length * 12) / (1024 * 1024) << "MB, input " << str.size() / (1024 * 1024) << "MB\n";
+		}
 		//continue;
 		//return 0;
 
@@ -829,6 +1631,63 @@ int main(int argc, char* argv[])
 		dd = std::chrono::steady_clock::now();
 		dur = std::chrono::duration_cast<std::chrono::milliseconds>(dd - c);
 		std::cout << "clean " << dur.count() << "ms\n";
+
+		// feature[_geometry][_coordinates], _Value keys vs KeyHandle.
+		if (ok && j.Get().is_structured() && j.Get()[1].is_array()) {
+			const claujson::Array* features_arr = j.Get()[1].as_array();
+			const claujson::KeyHandle h_geometry(_geometry), h_coordinates(_coordinates);
+			uint64_t found = 0;
+
+			c = std::chrono::steady_clock::now();
+			for (int i = 0; i < 10; ++i) {
+				for (auto& feature : *features_arr) {
+					found += feature[_geometry][_coordinates].is_array();
+				}
+			}
+			dd = std::chrono::steady_clock::now();
+			std::cout << "find (key) " << std::chrono::duration_cast<std::chrono::microseconds>(dd - c).count() << "us ";
+
+			c = std::chrono::steady_clock::now();
+			for (int i = 0; i < 10; ++i) {
+				for (auto& feature : *features_arr) {
+					found += feature[h_geometry][h_coordinates].is_array();
+				}
+			}
+			dd = std::chrono::steady_clock::now();
+			std::cout << "find (KeyHandle) " << std::chrono::duration_cast<std::chrono::microseconds>(dd - c).count() << "us " << found << "\n";
+
+			// x of first point of each feature, tree walk vs column.
+			double sum_walk = 0, sum_column = 0;
+			c = std::chrono::steady_clock::now();
+			for (auto& feature : *features_arr) {
+				const auto& x = feature[h_geometry][h_coordinates][0][0][0]; // float or int (set_int above)
+				if (x.is_float()) {
+					sum_walk += x.float_val();
+				}
+				else if (x.is_int()) {
+					sum_walk += x.int_val();
+				}
+			}
+			dd = std::chrono::steady_clock::now();
+			std::cout << "sum (tree walk) " << std::chrono::duration_cast<std::chrono::microseconds>(dd - c).count() << "us ";
+
+			claujson::extractor e(thr_num);
+			c = std::chrono::steady_clock::now();
+			claujson::my_vector<claujson::_Value> path;
+			path.push_back(claujson::_Value(d.GetAllocator(), "geometry"sv));
+			path.push_back(claujson::_Value(d.GetAllocator(), "coordinates"sv));
+			for (int i = 0; i < 3; ++i) {
+				path.push_back(claujson::_Value(0));
+			}
+			auto column = e.get_float(features_arr, path, thr_num);
+			dd = std::chrono::steady_clock::now();
+			for (uint64_t i = 0; i < column.size(); ++i) {
+				sum_column += column.data[i]; // not valid -> 0.
+			}
+			auto ee = std::chrono::steady_clock::now();
+			std::cout << "extract " << std::chrono::duration_cast<std::chrono::microseconds>(dd - c).count() << "us, sum (column) "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(ee - dd).count() << "us " << sum_walk << " " << sum_column << "\n";
+		}
 		{
 			for (int i = 0; i < 1; ++i) {
 				claujson::Document d;